@@ -25,48 +25,122 @@
 #include "add.h"
 #include "get.h"
 #include "element.h"
+#include "parse.h"
+#include "intern.h"
+#include "index.h"
 
-json_err json_addElement(struct json_element *root, unsigned char *parent, struct json_element **elementRet, unsigned char *name) {
+json_err json_addElement(struct json_element *root, unsigned char *parent, struct json_path *path, struct json_element **elementRet, unsigned char *name) {
 	json_err ret;
 	struct json_element *target;
+
+	if (!root || (!parent && !path) || !elementRet) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, parent, path, &target)) != JSON_ENONE) return ret;
+
+	return json_elementAppend(target, name, name ? strlen((char *)name) : 0, 0, JSON_DUPLICATE_REJECT, elementRet);
+}
+
+/* find the child of 'parent' with the given name (or NULL). 'hash' is json_internHash() of
+   the name, which lets most of the children be skipped without looking at their names */
+struct json_element *json_elementFindChild(struct json_element *parent, const unsigned char *name, unsigned int nameLen, uint32_t hash) {
+	struct json_element *child;
+	unsigned int n;
+
+	/* an array's index is a struct json_vector, and its children have no names anyway */
+	if ((parent->flags & ELEMENT_INDEXED) && parent->type == JSON_OBJECT) return json_indexFind(parent, name, nameLen, hash);
+
+	for (n = 0, child = parent->child_head; child; child = child->sibling_next, n++) {
+		if (!child->name || child->name_len != nameLen) continue;
+		if (child->name == name) break;
+		if ((child->flags & ELEMENT_INTERNED) && json_internHeader(child->name)->hash != hash) continue;
+		if (!memcmp(child->name, name, nameLen)) break;
+	}
+
+	/* that was a long way to look - next time, go straight to it. if there isn't the
+	   memory for an index, then it'll just be slower */
+	if (n >= (parent->json->indexWidth ? parent->json->indexWidth : JSON_INDEX_WIDTH) && parent->type == JSON_OBJECT) {
+		json_indexBuild(parent);
+	}
+
+	return child;
+}
+
+/* find the n'th child of 'parent' (or NULL) */
+struct json_element *json_elementChild(struct json_element *parent, unsigned int n) {
+	struct json_element *child;
+	unsigned int i, steps;
+
+	if (n >= parent->child_count) return NULL;
+	if ((parent->flags & ELEMENT_INDEXED) && parent->type == JSON_ARRAY) return json_indexChild(parent, n);
+
+	/* it's quicker to come back from the end */
+	if (n >= parent->child_count / 2) {
+		steps = parent->child_count - 1 - n;
+		for (i = parent->child_count - 1, child = json_elementTail(parent); i > n; i--, child = child->sibling_prev);
+	} else {
+		steps = n;
+		for (i = 0, child = parent->child_head; i < n; i++, child = child->sibling_next);
+	}
+
+	/* that was a long way to walk, and a wide array is likely to be gone through one by one -
+	   next time, go straight there. near the ends it's cheap enough not to bother, which keeps
+	   taking the children off the front one at a time from building it over and over */
+	if (steps >= (parent->json->indexWidth ? parent->json->indexWidth : JSON_INDEX_WIDTH) && parent->type == JSON_ARRAY) {
+		json_indexBuild(parent);
+	}
+
+	return child;
+}
+
+/* add a new child to the end of 'parent', without resolving any identifiers.
+   if 'borrow' is set, the element will point at 'name' rather than a copy of it.
+   'duplicates' decides what happens if 'parent' already has a child with this name */
+json_err json_elementAppend(struct json_element *parent, unsigned char *name, unsigned int nameLen, int borrow, enum json_duplicatePolicy duplicates, struct json_element **elementRet) {
+	json_err ret;
 	struct json_element *element;
+	struct json_element *existing;
 	unsigned char *name2;
+	uint32_t hash;
+
+	if (!parent || !elementRet) return JSON_EMISSINGPARAM;
+	if ((ret = json_parseExpand(parent)) != JSON_ENONE) return ret;
 
-	if (!root || !parent || !element) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, parent, &target)) != JSON_ENONE) return ret;
-	switch (target->type) {
+	existing = NULL;
+	switch (parent->type) {
 		case JSON_OBJECT:
 			if (!name) return JSON_EMISSINGPARAM;
-			if ((ret = json_getElement(target, name, NULL)) != JSON_EMISSING) return JSON_EEXISTS;
-			if ((name2 = malloc(strlen((char*)name) + 1)) == NULL) return JSON_ENOMEM;
-			strcpy((char*)name2, (char*)name);
+			hash = json_internHash(name, nameLen);
+			if (borrow) {
+				name2 = name;
+			} else {
+				/* objects tend to repeat the same few names, so they are only stored once */
+				if ((ret = json_intern(parent->json, name, nameLen, hash, &name2)) != JSON_ENONE) return ret;
+			}
+			if (duplicates != JSON_DUPLICATE_TRUST) {
+				existing = json_elementFindChild(parent, name2, nameLen, hash);
+				if (existing && duplicates == JSON_DUPLICATE_REJECT) return JSON_EEXISTS;
+			}
 			break;
 		case JSON_ARRAY:
 			if (name) return JSON_EPARENTISARRAY;
 			name2 = NULL;
+			nameLen = 0;
 			break;
 		default:
 			return JSON_ETYPEMISMATCH;
 	}
 
-	if ((ret = json_elementNew(&element)) != JSON_ENONE) {
-		if (name2) free(name2);
-		return ret;
-	}
-	element->json = root->json;
-	element->parent = target;
+	if ((ret = json_elementNew(parent->json, &element)) != JSON_ENONE) return ret;
 	element->name = name2;
+	element->name_len = nameLen;
+	if (!borrow && name2) element->flags |= ELEMENT_INTERNED;
 
 	/* link it up */
-	if (!target->child_head) {
-		/* there are no children yet */
-		target->child_head = element;
+	if (existing) {
+		/* the last one wins - take the place of the existing element */
+		json_elementReplace(existing, element);
+		json_elementDestroy(existing);
 	} else {
-		/* there are children... link it to the end */
-		struct json_element *sibling;
-		for (sibling = target->child_head; sibling && sibling->sibling_next; sibling = sibling->sibling_next);
-		sibling->sibling_next = element;
-		element->sibling_prev = sibling;
+		json_elementLink(parent, element);
 	}
 
 	*elementRet = element;
@@ -74,89 +148,138 @@ json_err json_addElement(struct json_element *root, unsigned char *parent, struc
 	return JSON_ENONE;
 }
 
-EXPORT json_err json_addNull(struct json_element *root, unsigned char *parent, unsigned char *name) {
+static json_err json_addNullAt(struct json_element *root, unsigned char *parent, struct json_path *path, unsigned char *name) {
 	json_err ret;
 	struct json_element *element;
 
-	if (!root || !parent) return JSON_EMISSINGPARAM;
-	if ((ret = json_addElement(root, parent, &element, name)) != JSON_ENONE) return ret;
+	if (!root || (!parent && !path)) return JSON_EMISSINGPARAM;
+	if ((ret = json_addElement(root, parent, path, &element, name)) != JSON_ENONE) return ret;
 
-	element->type = JSON_NULL;
+	return json_elementSetNull(element);
+}
 
-	return JSON_ENONE;
+EXPORT json_err json_addNull(struct json_element *root, unsigned char *parent, unsigned char *name) {
+	return json_addNullAt(root, parent, NULL, name);
 }
 
-EXPORT json_err json_addBoolean(struct json_element *root, unsigned char *parent, unsigned char *name, int data) {
+EXPORT json_err json_addNullPath(struct json_element *root, struct json_path *path, unsigned char *name) {
+	return json_addNullAt(root, NULL, path, name);
+}
+
+static json_err json_addBooleanAt(struct json_element *root, unsigned char *parent, struct json_path *path, unsigned char *name, int data) {
 	json_err ret;
 	struct json_element *element;
 
-	if (!root || !parent) return JSON_EMISSINGPARAM;
-	if ((ret = json_addElement(root, parent, &element, name)) != JSON_ENONE) return ret;
+	if (!root || (!parent && !path)) return JSON_EMISSINGPARAM;
+	if ((ret = json_addElement(root, parent, path, &element, name)) != JSON_ENONE) return ret;
 
-	element->type = JSON_BOOLEAN;
-	element->data.asInt = !!data;
+	return json_elementSetBoolean(element, data);
+}
 
-	return JSON_ENONE;
+EXPORT json_err json_addBoolean(struct json_element *root, unsigned char *parent, unsigned char *name, int data) {
+	return json_addBooleanAt(root, parent, NULL, name, data);
+}
+
+EXPORT json_err json_addBooleanPath(struct json_element *root, struct json_path *path, unsigned char *name, int data) {
+	return json_addBooleanAt(root, NULL, path, name, data);
 }
 
 EXPORT json_err json_addInteger(struct json_element *root, unsigned char *parent, unsigned char *name, int data) {
+	return json_addInteger64(root, parent, name, data);
+}
+
+EXPORT json_err json_addIntegerPath(struct json_element *root, struct json_path *path, unsigned char *name, int data) {
+	return json_addInteger64Path(root, path, name, data);
+}
+
+static json_err json_addInteger64At(struct json_element *root, unsigned char *parent, struct json_path *path, unsigned char *name, int64_t data) {
 	json_err ret;
 	struct json_element *element;
 
-	if (!root || !parent) return JSON_EMISSINGPARAM;
-	if ((ret = json_addElement(root, parent, &element, name)) != JSON_ENONE) return ret;
+	if (!root || (!parent && !path)) return JSON_EMISSINGPARAM;
+	if ((ret = json_addElement(root, parent, path, &element, name)) != JSON_ENONE) return ret;
 
-	element->type = JSON_INTEGER;
-	element->data.asInt = data;
+	return json_elementSetInteger64(element, data);
+}
 
-	return JSON_ENONE;
+EXPORT json_err json_addInteger64(struct json_element *root, unsigned char *parent, unsigned char *name, int64_t data) {
+	return json_addInteger64At(root, parent, NULL, name, data);
 }
 
-EXPORT json_err json_addFloat(struct json_element *root, unsigned char *parent, unsigned char *name, double data) {
+EXPORT json_err json_addInteger64Path(struct json_element *root, struct json_path *path, unsigned char *name, int64_t data) {
+	return json_addInteger64At(root, NULL, path, name, data);
+}
+
+static json_err json_addUInteger64At(struct json_element *root, unsigned char *parent, struct json_path *path, unsigned char *name, uint64_t data) {
 	json_err ret;
 	struct json_element *element;
 
-	if (!root || !parent) return JSON_EMISSINGPARAM;
-	if ((ret = json_addElement(root, parent, &element, name)) != JSON_ENONE) return ret;
+	if (!root || (!parent && !path)) return JSON_EMISSINGPARAM;
+	if ((ret = json_addElement(root, parent, path, &element, name)) != JSON_ENONE) return ret;
 
-	element->type = JSON_FLOAT;
-	element->data.asFloat = data;
+	return json_elementSetUInteger64(element, data);
+}
 
-	return JSON_ENONE;
+EXPORT json_err json_addUInteger64(struct json_element *root, unsigned char *parent, unsigned char *name, uint64_t data) {
+	return json_addUInteger64At(root, parent, NULL, name, data);
 }
 
-EXPORT json_err json_addString(struct json_element *root, unsigned char *parent, unsigned char *name, unsigned char *data, unsigned int dataLen) {
+EXPORT json_err json_addUInteger64Path(struct json_element *root, struct json_path *path, unsigned char *name, uint64_t data) {
+	return json_addUInteger64At(root, NULL, path, name, data);
+}
+
+static json_err json_addFloatAt(struct json_element *root, unsigned char *parent, struct json_path *path, unsigned char *name, double data) {
+	json_err ret;
+	struct json_element *element;
+
+	if (!root || (!parent && !path)) return JSON_EMISSINGPARAM;
+	if ((ret = json_addElement(root, parent, path, &element, name)) != JSON_ENONE) return ret;
+
+	return json_elementSetFloat(element, data);
+}
+
+EXPORT json_err json_addFloat(struct json_element *root, unsigned char *parent, unsigned char *name, double data) {
+	return json_addFloatAt(root, parent, NULL, name, data);
+}
+
+EXPORT json_err json_addFloatPath(struct json_element *root, struct json_path *path, unsigned char *name, double data) {
+	return json_addFloatAt(root, NULL, path, name, data);
+}
+
+static json_err json_addStringAt(struct json_element *root, unsigned char *parent, struct json_path *path, unsigned char *name, unsigned char *data, unsigned int dataLen) {
 	json_err ret;
 	struct json_element *element;
-	unsigned char *data2;
 
-	if (!root || !parent || !data) return JSON_EMISSINGPARAM;
-	if ((data2 = malloc(dataLen + 1)) == NULL) return JSON_ENOMEM;
-	memcpy(data2, data, dataLen);
-	data2[dataLen] = '\0';
+	if (!root || (!parent && !path) || !data) return JSON_EMISSINGPARAM;
+	if ((ret = json_addElement(root, parent, path, &element, name)) != JSON_ENONE) return ret;
 
-	if ((ret = json_addElement(root, parent, &element, name)) != JSON_ENONE) {
-		free(data2);
+	if ((ret = json_elementSetString(element, data, dataLen)) != JSON_ENONE) {
+		json_elementUnlink(element);
+		json_elementDestroy(element);
 		return ret;
 	}
 
-	element->type = JSON_STRING;
-	element->data_len = dataLen;
-	element->data.asRaw = data2;
-
 	return JSON_ENONE;
 }
 
+EXPORT json_err json_addString(struct json_element *root, unsigned char *parent, unsigned char *name, unsigned char *data, unsigned int dataLen) {
+	return json_addStringAt(root, parent, NULL, name, data, dataLen);
+}
+
+EXPORT json_err json_addStringPath(struct json_element *root, struct json_path *path, unsigned char *name, unsigned char *data, unsigned int dataLen) {
+	return json_addStringAt(root, NULL, path, name, data, dataLen);
+}
+
 EXPORT json_err json_addFunction(struct json_element *root, unsigned char *parent, unsigned char *name, unsigned char *data, unsigned int dataLen) {
 	return JSON_ENOTIMPLEMENTED;
 }
 
-EXPORT json_err json_addObject(struct json_element *root, unsigned char *parent, unsigned char *name, struct json_element **elementRet) {
+static json_err json_addObjectAt(struct json_element *root, unsigned char *parent, struct json_path *path, unsigned char *name, struct json_element **elementRet) {
 	json_err ret;
 	struct json_element *element;
 
-	if (!root || !parent) return JSON_EMISSINGPARAM;
-	if ((ret = json_addElement(root, parent, &element, name)) != JSON_ENONE) return ret;
+	if (!root || (!parent && !path)) return JSON_EMISSINGPARAM;
+	if ((ret = json_addElement(root, parent, path, &element, name)) != JSON_ENONE) return ret;
 
 	element->type = JSON_OBJECT;
 
@@ -165,12 +288,20 @@ EXPORT json_err json_addObject(struct json_element *root, unsigned char *parent,
 	return JSON_ENONE;
 }
 
-EXPORT json_err json_addArray(struct json_element *root, unsigned char *parent, unsigned char *name, struct json_element **elementRet) {
+EXPORT json_err json_addObject(struct json_element *root, unsigned char *parent, unsigned char *name, struct json_element **elementRet) {
+	return json_addObjectAt(root, parent, NULL, name, elementRet);
+}
+
+EXPORT json_err json_addObjectPath(struct json_element *root, struct json_path *path, unsigned char *name, struct json_element **elementRet) {
+	return json_addObjectAt(root, NULL, path, name, elementRet);
+}
+
+static json_err json_addArrayAt(struct json_element *root, unsigned char *parent, struct json_path *path, unsigned char *name, struct json_element **elementRet) {
 	json_err ret;
 	struct json_element *element;
 
-	if (!root || !parent) return JSON_EMISSINGPARAM;
-	if ((ret = json_addElement(root, parent, &element, name)) != JSON_ENONE) return ret;
+	if (!root || (!parent && !path)) return JSON_EMISSINGPARAM;
+	if ((ret = json_addElement(root, parent, path, &element, name)) != JSON_ENONE) return ret;
 
 	element->type = JSON_ARRAY;
 
@@ -179,3 +310,11 @@ EXPORT json_err json_addArray(struct json_element *root, unsigned char *parent,
 	return JSON_ENONE;
 }
 
+EXPORT json_err json_addArray(struct json_element *root, unsigned char *parent, unsigned char *name, struct json_element **elementRet) {
+	return json_addArrayAt(root, parent, NULL, name, elementRet);
+}
+
+EXPORT json_err json_addArrayPath(struct json_element *root, struct json_path *path, unsigned char *name, struct json_element **elementRet) {
+	return json_addArrayAt(root, NULL, path, name, elementRet);
+}
+
@@ -20,6 +20,9 @@
 	along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-json_err json_addElement(struct json_element *root, unsigned char *parent, struct json_element **element, unsigned char *name);
+json_err json_addElement(struct json_element *root, unsigned char *parent, struct json_path *path, struct json_element **element, unsigned char *name);
+json_err json_elementAppend(struct json_element *parent, unsigned char *name, unsigned int nameLen, int borrow, enum json_duplicatePolicy duplicates, struct json_element **element);
+struct json_element *json_elementChild(struct json_element *parent, unsigned int n);
+struct json_element *json_elementFindChild(struct json_element *parent, const unsigned char *name, unsigned int nameLen, uint32_t hash);
 
 #endif /* __ADD_H */
@@ -0,0 +1,57 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_int.h"
+#include "alloc.h"
+
+static void *json_allocMalloc(void *ctx, size_t size) {
+	return malloc(size);
+}
+static void *json_allocRealloc(void *ctx, void *ptr, size_t size) {
+	return realloc(ptr, size);
+}
+static void json_allocFree(void *ctx, void *ptr) {
+	free(ptr);
+}
+
+const struct json_allocator json_allocDefault = {
+	.alloc   = json_allocMalloc,
+	.realloc = json_allocRealloc,
+	.free    = json_allocFree,
+	.ctx     = NULL,
+};
+
+void *json_alloc(const struct json_allocator *allocator, size_t size) {
+	if (!allocator) allocator = &json_allocDefault;
+	return allocator->alloc(allocator->ctx, size);
+}
+
+void *json_realloc(const struct json_allocator *allocator, void *ptr, size_t size) {
+	if (!allocator) allocator = &json_allocDefault;
+	return allocator->realloc(allocator->ctx, ptr, size);
+}
+
+void json_free(const struct json_allocator *allocator, void *ptr) {
+	if (!allocator) allocator = &json_allocDefault;
+	if (ptr) allocator->free(allocator->ctx, ptr);
+}
@@ -0,0 +1,31 @@
+#ifndef __ALLOC_H
+#define __ALLOC_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* malloc() / realloc() / free() */
+extern const struct json_allocator json_allocDefault;
+
+/* these use 'allocator', or json_allocDefault if it is NULL */
+void *json_alloc(const struct json_allocator *allocator, size_t size);
+void *json_realloc(const struct json_allocator *allocator, void *ptr, size_t size);
+void json_free(const struct json_allocator *allocator, void *ptr);
+
+#endif /* __ALLOC_H */
@@ -0,0 +1,201 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_int.h"
+#include "arena.h"
+
+/* keep everything aligned well enough for an int64_t / double / pointer */
+#define ARENA_ALIGN(x) (((x) + 7) & ~(size_t)7)
+#define ARENA_HEAD     ARENA_ALIGN(sizeof(struct json_arenaChunk))
+
+/* take the smallest chunk that we had before that still has room for 'size', or NULL */
+static struct json_arenaChunk *json_arenaUnused(struct json_arena *arena, size_t size) {
+	struct json_arenaChunk **c, **best;
+	struct json_arenaChunk *chunk;
+
+	best = NULL;
+	for (c = &arena->unused; *c; c = &(*c)->next) {
+		if ((*c)->size - ARENA_HEAD < size) continue;
+		if (!best || (*c)->size < (*best)->size) best = c;
+	}
+	if (!best) return NULL;
+
+	chunk = *best;
+	*best = chunk->next;
+	chunk->used = ARENA_HEAD;
+	return chunk;
+}
+
+json_err json_arenaAlloc(struct json_arena *arena, size_t size, void **ptr) {
+	struct json_arenaChunk *chunk;
+	size_t want;
+
+	if (!arena || !ptr) return JSON_EMISSINGPARAM;
+	size = ARENA_ALIGN(size);
+
+	chunk = arena->head;
+	if (!chunk || chunk->size - chunk->used < size) {
+		if (arena->next < JSON_ARENA_CHUNK) arena->next = JSON_ARENA_CHUNK;
+		if (chunk && ARENA_HEAD + size > arena->next / 2) {
+			/* big ones get a chunk to themselves, so the current one keeps going */
+			if ((chunk = json_arenaUnused(arena, size)) == NULL) {
+				if ((chunk = json_alloc(arena->allocator, ARENA_HEAD + size)) == NULL) return JSON_ENOMEM;
+				chunk->size = ARENA_HEAD + size;
+				chunk->used = ARENA_HEAD;
+			}
+			chunk->next = arena->head->next;
+			arena->head->next = chunk;
+		} else if ((chunk = json_arenaUnused(arena, size)) != NULL) {
+			/* one that we had before */
+			chunk->next = arena->head;
+			arena->head = chunk;
+		} else {
+			want = arena->next;
+			if (want < ARENA_HEAD + size) want = ARENA_HEAD + size;
+			if ((chunk = json_alloc(arena->allocator, want)) == NULL) return JSON_ENOMEM;
+			chunk->size = want;
+			chunk->used = ARENA_HEAD;
+			chunk->next = arena->head;
+			arena->head = chunk;
+			if (arena->next < JSON_ARENA_CHUNK_MAX) arena->next *= 2;
+		}
+	}
+
+	*ptr = &(((unsigned char *)chunk)[chunk->used]);
+	chunk->used += size;
+
+	return JSON_ENONE;
+}
+
+/* copy 'len' bytes into the arena, and terminate them */
+json_err json_arenaCopy(struct json_arena *arena, const unsigned char *data, unsigned int len, unsigned char **copy) {
+	json_err ret;
+	void *p;
+
+	if (!arena || !data || !copy) return JSON_EMISSINGPARAM;
+	if ((ret = json_arenaAlloc(arena, len + 1, &p)) != JSON_ENONE) return ret;
+	memcpy(p, data, len);
+	((unsigned char *)p)[len] = '\0';
+	*copy = p;
+
+	return JSON_ENONE;
+}
+
+/* a zeroed element - one that was destroyed earlier, if there is one */
+json_err json_arenaNewElement(struct json_arena *arena, struct json_element **element) {
+	json_err ret;
+	void *p;
+
+	if (!arena || !element) return JSON_EMISSINGPARAM;
+	if (arena->spare) {
+		p = arena->spare;
+		arena->spare = arena->spare->sibling_next;
+	} else if ((ret = json_arenaAlloc(arena, sizeof(**element), &p)) != JSON_ENONE) {
+		return ret;
+	}
+	memset(p, 0, sizeof(**element));
+	*element = p;
+
+	return JSON_ENONE;
+}
+
+void json_arenaSpareElement(struct json_arena *arena, struct json_element *element) {
+	element->sibling_next = arena->spare;
+	arena->spare = element;
+}
+
+/* take on all of the chunks that belong to 'from' (e.g: once its elements have been moved
+   into our document). 'from' is left empty */
+void json_arenaTake(struct json_arena *arena, struct json_arena *from) {
+	struct json_arenaChunk *last;
+	struct json_element *spare;
+
+	if (from->head) {
+		for (last = from->head; last->next; last = last->next);
+		if (arena->head) {
+			/* keep carving up our current chunk */
+			last->next = arena->head->next;
+			arena->head->next = from->head;
+		} else {
+			arena->head = from->head;
+			arena->next = from->next;
+		}
+	}
+	if (from->spare) {
+		for (spare = from->spare; spare->sibling_next; spare = spare->sibling_next);
+		spare->sibling_next = arena->spare;
+		arena->spare = from->spare;
+	}
+
+	from->head = NULL;
+	from->spare = NULL;
+}
+
+/* forget everything that has been handed out, but hang on to the biggest chunk for next time */
+void json_arenaReset(struct json_arena *arena) {
+	struct json_arenaChunk *chunk, *keep;
+
+	keep = NULL;
+	while ((chunk = arena->head) != NULL) {
+		arena->head = chunk->next;
+		if (!keep || chunk->size > keep->size) {
+			if (keep) json_free(arena->allocator, keep);
+			keep = chunk;
+		} else {
+			json_free(arena->allocator, chunk);
+		}
+	}
+	if (keep) {
+		keep->next = NULL;
+		keep->used = ARENA_HEAD;
+	}
+	arena->head = keep;
+	arena->spare = NULL;
+}
+
+/* forget everything that has been handed out, but keep every chunk to be used again */
+void json_arenaRewind(struct json_arena *arena) {
+	struct json_arenaChunk *chunk;
+
+	while ((chunk = arena->head) != NULL) {
+		arena->head = chunk->next;
+		chunk->next = arena->unused;
+		arena->unused = chunk;
+	}
+	arena->spare = NULL;
+}
+
+void json_arenaFree(struct json_arena *arena) {
+	struct json_arenaChunk *chunk;
+
+	while ((chunk = arena->head) != NULL) {
+		arena->head = chunk->next;
+		json_free(arena->allocator, chunk);
+	}
+	while ((chunk = arena->unused) != NULL) {
+		arena->unused = chunk->next;
+		json_free(arena->allocator, chunk);
+	}
+	arena->spare = NULL;
+	arena->next = 0;
+}
@@ -0,0 +1,53 @@
+#ifndef __ARENA_H
+#define __ARENA_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* the first chunk's size - each one after that is twice as big as the last, up to the max */
+#define JSON_ARENA_CHUNK     (16 * 1024)
+#define JSON_ARENA_CHUNK_MAX (1024 * 1024)
+
+struct json_arenaChunk {
+	struct json_arenaChunk *next;
+	size_t size;
+	size_t used;
+};
+
+/* everything that makes up a document (elements, names and strings) is carved out of
+   a list of chunks, and only given back all at once. elements that are destroyed along
+   the way are kept on a list, and reused */
+struct json_arena {
+	struct json_arenaChunk *head; /* the chunk that is being carved up */
+	struct json_element *spare;
+	struct json_arenaChunk *unused; /* kept by json_arenaRewind(), to be carved up again */
+	size_t next; /* the size of the next chunk */
+	const struct json_allocator *allocator; /* NULL = malloc() */
+};
+
+json_err json_arenaAlloc(struct json_arena *arena, size_t size, void **ptr);
+json_err json_arenaCopy(struct json_arena *arena, const unsigned char *data, unsigned int len, unsigned char **copy);
+json_err json_arenaNewElement(struct json_arena *arena, struct json_element **element);
+void json_arenaSpareElement(struct json_arena *arena, struct json_element *element);
+void json_arenaTake(struct json_arena *arena, struct json_arena *from);
+void json_arenaReset(struct json_arena *arena);
+void json_arenaRewind(struct json_arena *arena);
+void json_arenaFree(struct json_arena *arena);
+
+#endif /* __ARENA_H */
@@ -0,0 +1,190 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_int.h"
+#include "batch.h"
+#include "path.h"
+
+/* find the child of 'parent' that takes the same step as 'segment', or add one */
+static json_err json_batchNode(struct json_batch *batch, unsigned int parent, struct json_pathSegment *segment, unsigned int *nodeRet) {
+	struct json_batchNode *nodes, *node;
+	struct json_pathSegment *s;
+	unsigned int n;
+
+	for (n = batch->nodes[parent].child; n; n = batch->nodes[n].next) {
+		s = batch->nodes[n].segment;
+		if (!s->name != !segment->name) continue;
+		if (segment->name) {
+			if (s->hash == segment->hash && s->nameLen == segment->nameLen && !memcmp(s->name, segment->name, segment->nameLen)) break;
+		} else {
+			if (s->index == segment->index) break;
+		}
+	}
+	if (n) {
+		*nodeRet = n;
+		return JSON_ENONE;
+	}
+
+	if (batch->nodeCount == batch->nodeLen) {
+		if ((nodes = json_realloc(NULL, batch->nodes, sizeof(*nodes) * batch->nodeLen * 2)) == NULL) return JSON_ENOMEM;
+		batch->nodes = nodes;
+		batch->nodeLen *= 2;
+	}
+
+	n = batch->nodeCount++;
+	node = &(batch->nodes[n]);
+	node->segment = segment;
+	node->child = 0;
+	node->result = -1;
+	node->next = batch->nodes[parent].child;
+	batch->nodes[parent].child = n;
+
+	*nodeRet = n;
+
+	return JSON_ENONE;
+}
+
+static json_err json_batchBuild(struct json_path **paths, struct json_path **owned, struct json_batch **batchRet) {
+	json_err ret;
+	struct json_batch *batch;
+	unsigned int count, i, j, n;
+	int *last;
+
+	for (count = 0; paths[count]; count++);
+
+	if ((batch = json_alloc(NULL, sizeof(*batch) + (sizeof(*batch->sameEnd) * count))) == NULL) return JSON_ENOMEM;
+	memset(batch, 0, sizeof(*batch));
+	batch->count = count;
+	batch->sameEnd = (int *)&(batch[1]);
+	batch->owned = owned;
+	batch->nodeLen = 16;
+	if ((batch->nodes = json_alloc(NULL, sizeof(*batch->nodes) * batch->nodeLen)) == NULL) {
+		json_free(NULL, batch);
+		return JSON_ENOMEM;
+	}
+	batch->nodeCount = 1;
+	memset(batch->nodes, 0, sizeof(*batch->nodes));
+	batch->nodes[0].result = -1;
+
+	for (i = 0; i < count; i++) {
+		for (j = 0, n = 0; j < paths[i]->count; j++) {
+			if ((ret = json_batchNode(batch, n, &(paths[i]->segments[j]), &n)) != JSON_ENONE) {
+				batch->owned = NULL;
+				json_batchFree(batch);
+				return ret;
+			}
+		}
+
+		/* add it to the end of the list of paths that end here, to keep them in order */
+		batch->sameEnd[i] = -1;
+		if (batch->nodes[n].result == -1) {
+			batch->nodes[n].result = i;
+		} else {
+			for (last = &(batch->nodes[n].result); *last != -1; last = &(batch->sameEnd[*last]));
+			*last = i;
+		}
+	}
+
+	*batchRet = batch;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_batchCompile(unsigned char **paths, struct json_batch **batchRet) {
+	json_err ret;
+	struct json_path **owned;
+	unsigned int count, i;
+
+	if (!paths || !batchRet) return JSON_EMISSINGPARAM;
+
+	for (count = 0; paths[count]; count++);
+	if ((owned = json_alloc(NULL, sizeof(*owned) * (count + 1))) == NULL) return JSON_ENOMEM;
+	memset(owned, 0, sizeof(*owned) * (count + 1));
+
+	for (i = 0; i < count; i++) {
+		if ((ret = json_pathCompile(paths[i], &(owned[i]))) != JSON_ENONE) break;
+	}
+	if (i < count || (ret = json_batchBuild(owned, owned, batchRet)) != JSON_ENONE) {
+		for (i = 0; owned[i]; i++) json_pathFree(owned[i]);
+		json_free(NULL, owned);
+		return ret;
+	}
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_batchCompilePaths(struct json_path **paths, struct json_batch **batchRet) {
+	if (!paths || !batchRet) return JSON_EMISSINGPARAM;
+	return json_batchBuild(paths, NULL, batchRet);
+}
+
+EXPORT json_err json_batchFree(struct json_batch *batch) {
+	unsigned int i;
+
+	if (!batch) return JSON_EMISSINGPARAM;
+
+	if (batch->owned) {
+		for (i = 0; batch->owned[i]; i++) json_pathFree(batch->owned[i]);
+		json_free(NULL, batch->owned);
+	}
+	json_free(NULL, batch->nodes);
+	json_free(NULL, batch);
+
+	return JSON_ENONE;
+}
+
+/* fill in the results for the paths that end at 'node', and then go on to its children */
+static json_err json_batchWalk(struct json_batch *batch, unsigned int node, struct json_element *element, struct json_batchResult *results) {
+	json_err ret;
+	struct json_element *child;
+	unsigned int n;
+	int i;
+
+	for (i = batch->nodes[node].result; i != -1; i = batch->sameEnd[i]) {
+		results[i].element = element;
+		results[i].type = element->type;
+	}
+
+	for (n = batch->nodes[node].child; n; n = batch->nodes[n].next) {
+		ret = json_pathStep(element, batch->nodes[n].segment, &child);
+		/* it isn't there, so neither is anything under it */
+		if (ret == JSON_EMISSING) continue;
+		if (ret != JSON_ENONE) return ret;
+		if ((ret = json_batchWalk(batch, n, child, results)) != JSON_ENONE) return ret;
+	}
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_batchGet(struct json_element *root, struct json_batch *batch, struct json_batchResult *results) {
+	unsigned int i;
+
+	if (!root || !batch || !results) return JSON_EMISSINGPARAM;
+
+	for (i = 0; i < batch->count; i++) {
+		results[i].element = NULL;
+		results[i].type = JSON_MISSING;
+	}
+
+	return json_batchWalk(batch, 0, root, results);
+}
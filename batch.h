@@ -0,0 +1,41 @@
+#ifndef __BATCH_H
+#define __BATCH_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* the paths given to json_batchCompile(), as a tree - paths that start the same way
+   share nodes, so that part of the document is only looked through once */
+struct json_batchNode {
+	struct json_pathSegment *segment; /* NULL for the root */
+	unsigned int child;               /* the first child, or 0 if there aren't any */
+	unsigned int next;                /* the next sibling, or 0 */
+	int result;                       /* the first path that ends here, or -1 */
+};
+
+struct json_batch {
+	unsigned int count;        /* the number of paths */
+	int *sameEnd;              /* for each path, the next path that ends at the same node, or -1 */
+	struct json_path **owned;  /* the paths that we compiled ourselves, or NULL */
+	struct json_batchNode *nodes;
+	unsigned int nodeCount;
+	unsigned int nodeLen;
+};
+
+#endif /* __BATCH_H */
@@ -22,24 +22,36 @@
 #include <stdarg.h>
 #include <string.h>
 
+#include <limits.h>
+
 #include "json_int.h"
 #include "buf.h"
 
 #define BUF_EXPAND_SIZE 4096
 
-/* makes the whole buffer BUF_EXPAND_SIZE / 'extra' longer */
+/* makes the whole buffer at least BUF_EXPAND_SIZE / 'extra' longer */
 json_err json_bufExpand(struct json_buf *buf) {
 	return json_bufnExpand(buf, BUF_EXPAND_SIZE);
 }
 json_err json_bufnExpand(struct json_buf *buf, size_t extra) {
 	unsigned char *nBuf;
-	unsigned int nBufLen;
+	size_t nBufLen, grow;
 
 	if (!buf) return JSON_EMISSINGPARAM;
 
-	nBufLen = buf->len + extra;
+	/* grow in proportion to what is already there, so that the copying evens out */
+	grow = (size_t)buf->len * (buf->growth ? buf->growth : BUF_GROWTH) / 100;
+	if (grow < extra) grow = extra;
+	if (grow < BUF_EXPAND_SIZE) grow = BUF_EXPAND_SIZE;
+
+	nBufLen = buf->len + grow;
+	if (nBufLen > UINT_MAX) {
+		/* lengths are unsigned ints - settle for what is needed, if that fits */
+		if ((size_t)buf->len + extra > UINT_MAX) return JSON_ENOMEM;
+		nBufLen = UINT_MAX;
+	}
 
-	if ((nBuf = realloc(buf->data, nBufLen)) == NULL) return JSON_ENOMEM;
+	if ((nBuf = json_realloc(buf->allocator, buf->data, nBufLen)) == NULL) return JSON_ENOMEM;
 
 	buf->data = nBuf;
 	buf->len = nBufLen;
@@ -49,11 +61,11 @@ json_err json_bufnExpand(struct json_buf *buf, size_t extra) {
 
 /* ensures that there is at least 'extra' bytes after pos in the buffer */
 json_err json_bufSpace(struct json_buf *buf, size_t extra) {
-	unsigned int nBytes;
+	size_t nBytes;
 
 	if (!buf) return JSON_EMISSINGPARAM;
 
-	nBytes  = buf->pos + extra;
+	nBytes  = (size_t)buf->pos + extra;
 	if (nBytes < buf->len) return JSON_ENONE;
 
 	return json_bufnExpand(buf, nBytes - buf->len);
@@ -109,13 +121,8 @@ json_err _json_bufvPrintf(struct json_buf *buf, const unsigned char *format, va_
 	}
 	if (!recurse) return JSON_ENOMEM;
 
-	/* over allocate if we are just after a small amount of data... */
-	if (needed < BUF_EXPAND_SIZE) {
-		ret = json_bufExpand(buf);
-	} else {
-		ret = json_bufnExpand(buf, needed);
-	}
-	if (ret != JSON_ENONE) return ret;
+	/* there needs to be room for the '\0' as well */
+	if ((ret = json_bufSpace(buf, printed + 1)) != JSON_ENONE) return ret;
 
 	return _json_bufvPrintf(buf, format, ap, 0);
 }
@@ -126,10 +133,22 @@ json_err json_bufTrim(struct json_buf *buf) {
 
 	if (!buf) return JSON_EMISSINGPARAM;
 
-	if ((nBuf = realloc(buf->data, buf->pos + 1)) == NULL) return JSON_ENOMEM;
+	if ((nBuf = json_realloc(buf->allocator, buf->data, buf->pos + 1)) == NULL) return JSON_ENOMEM;
 
 	buf->data = nBuf;
 	buf->len = buf->pos + 1;
 
 	return JSON_ENONE;
 }
+
+/* drop 'len' bytes from the front of the buffer (keeping the '\0'), and move pos back */
+json_err json_bufDiscard(struct json_buf *buf, unsigned int len) {
+	if (!buf) return JSON_EMISSINGPARAM;
+	if (len > buf->pos) return JSON_EINVAL;
+	if (len == 0) return JSON_ENONE;
+
+	memmove(buf->data, &(buf->data[len]), buf->pos - len + 1);
+	buf->pos -= len;
+
+	return JSON_ENONE;
+}
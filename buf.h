@@ -20,13 +20,19 @@
 	along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+/* unless told otherwise, a buffer doubles in size each time that it runs out */
+#define BUF_GROWTH 100
+
 struct json_buf {
 	unsigned int len;
 	unsigned int pos;
 	unsigned char *data;
+	const struct json_allocator *allocator; /* NULL = malloc() */
+	unsigned int growth; /* how much to grow by, as a percentage of len (0 = BUF_GROWTH) */
 };
 
-/* these will add BUF_EXPAND_SIZE / 'extra' bytes to the buffer */
+/* these will add at least BUF_EXPAND_SIZE / 'extra' bytes to the buffer, or 'growth'
+   percent of its length if that's more, so that filling it up is never quadratic */
 json_err json_bufExpand(struct json_buf *buf);
 json_err json_bufnExpand(struct json_buf *buf, size_t extra);
 
@@ -41,7 +47,11 @@ json_err json_bufPrintf(struct json_buf *buf, const unsigned char *format, ...);
 json_err json_bufvPrintf(struct json_buf *buf, const unsigned char *format, va_list ap);
 json_err _json_bufvPrintf(struct json_buf *buf, const unsigned char *format, va_list ap, int recurse);
 
-/* trim the buffer to pos (which should point to the terminating NUL) */
+/* trim the buffer to pos (which should point to the terminating NUL). buffers that are
+   kept for reuse (e.g: the parse buffer) are never trimmed */
 json_err json_bufTrim(struct json_buf *buf);
 
+/* drop the first 'len' bytes from the buffer, moving the rest down to the start */
+json_err json_bufDiscard(struct json_buf *buf, unsigned int len);
+
 #endif /* __BUF_H */
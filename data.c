@@ -23,29 +23,66 @@
 
 #include "json_int.h"
 #include "get.h"
+#include "data.h"
 
-EXPORT json_err json_dataGet(struct json_element *root, unsigned char *identifier, void **user_data) {
+json_err json_userDataSet(struct json_element *element, void *data) {
+	json_err ret;
+	struct json *json;
+
+	json = element->json;
+	if ((ret = json_mapSet(&json->allocator, &json->userData, element, data)) != JSON_ENONE) return ret;
+	element->flags |= ELEMENT_USERDATA;
+
+	return JSON_ENONE;
+}
+
+void *json_userDataGet(struct json_element *element) {
+	if (!(element->flags & ELEMENT_USERDATA)) return NULL;
+	return json_mapGet(&element->json->userData, element);
+}
+
+void json_userDataRemove(struct json_element *element) {
+	if (!(element->flags & ELEMENT_USERDATA)) return;
+	element->flags &= ~ELEMENT_USERDATA;
+	json_mapRemove(&element->json->userData, element);
+}
+
+static json_err json_dataGetAt(struct json_element *root, unsigned char *identifier, struct json_path *path, void **user_data) {
 	json_err ret;
 	struct json_element *target;
 
-	if (!root || !identifier || !user_data) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
+	if (!root || (!identifier && !path) || !user_data) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
 	if (!target) return JSON_EMISSING;
 
-	*user_data = target->user_data;
+	*user_data = json_userDataGet(target);
 
 	return JSON_ENONE;
 }
 
-EXPORT json_err json_dataSet(struct json_element *root, unsigned char *identifier, void *user_data) {
+EXPORT json_err json_dataGet(struct json_element *root, unsigned char *identifier, void **user_data) {
+	return json_dataGetAt(root, identifier, NULL, user_data);
+}
+
+EXPORT json_err json_dataGetPath(struct json_element *root, struct json_path *path, void **user_data) {
+	return json_dataGetAt(root, NULL, path, user_data);
+}
+
+static json_err json_dataSetAt(struct json_element *root, unsigned char *identifier, struct json_path *path, void *user_data) {
 	json_err ret;
 	struct json_element *target;
 
-	if (!root || !identifier || !user_data) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
+	if (!root || (!identifier && !path) || !user_data) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
 	if (!target) return JSON_EMISSING;
 
-	target->user_data = user_data;
+	return json_userDataSet(target, user_data);
+}
 
-	return JSON_ENONE;
+EXPORT json_err json_dataSet(struct json_element *root, unsigned char *identifier, void *user_data) {
+	return json_dataSetAt(root, identifier, NULL, user_data);
+}
+
+EXPORT json_err json_dataSetPath(struct json_element *root, struct json_path *path, void *user_data) {
+	return json_dataSetAt(root, NULL, path, user_data);
 }
@@ -25,34 +25,20 @@
 #include "element.h"
 #include "get.h"
 
-EXPORT json_err json_deleteElement(struct json_element *root, unsigned char *identifier) {
+static json_err json_deleteElementAt(struct json_element *root, unsigned char *identifier, struct json_path *path) {
 	json_err ret;
 	struct json_element *target;
 
-	if (!root || !identifier) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
-	if (!target) return JSON_EMISSING;
-
-	if (target->parent && target->parent->child_head == target) {
-		/* in this case, we must relink the parent to a sibling */
-		if (target->sibling_prev) {
-			target->parent->child_head = target->sibling_prev;
-		} else {
-			target->parent->child_head = target->sibling_next;
-		}
-		target->parent = NULL;
-	}
-
-	if (target->sibling_prev) {
-		target->sibling_prev->sibling_next = target->sibling_next;
-		target->sibling_prev = NULL;
-	}
-
-	if (target->sibling_next) {
-		target->sibling_next->sibling_prev = target->sibling_prev;
-		target->sibling_next = NULL;
-	}
-
-	/* we are now completely un-linked... destroy us and all our children */
-	return json_elementDestroy(target);
+	if (!root || (!identifier && !path)) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
+
+	return json_elementRemove(target);
+}
+
+EXPORT json_err json_deleteElement(struct json_element *root, unsigned char *identifier) {
+	return json_deleteElementAt(root, identifier, NULL);
+}
+
+EXPORT json_err json_deleteElementPath(struct json_element *root, struct json_path *path) {
+	return json_deleteElementAt(root, NULL, path);
 }
@@ -20,57 +20,402 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #include "json_int.h"
 #include "element.h"
+#include "add.h"
+#include "parse.h"
+#include "data.h"
+#include "index.h"
 
 /* just to clear things up... an ELEMENT is a 'name': 'value' pair.
    in the case that the parent of an element is an ARRAY, no name is permitted
    an OBJECT is an ELEMENT with type OBJECT
 */
 
-json_err json_elementNew(struct json_element **elementRet) {
+json_err json_elementNew(struct json *json, struct json_element **elementRet) {
+	json_err ret;
 	struct json_element *element;
 
-	if (!elementRet) return JSON_EMISSINGPARAM;
+	if (!json || !elementRet) return JSON_EMISSINGPARAM;
 
-	if ((element = malloc(sizeof(*element))) == NULL) return JSON_ENOMEM;
-	memset(element, 0, sizeof(*element));
+	if ((ret = json_arenaNewElement(&json->arena, &element)) != JSON_ENONE) return ret;
+	element->json = json;
 
 	*elementRet = element;
 
 	return JSON_ENONE;
 }
 
+/* destroy the element, all of the siblings that come after it, and everything under them.
+   the names and strings stay in the arena until json_destroy(), but the elements are reused */
 json_err json_elementDestroy(struct json_element *element) {
+	struct json_element *next;
+
 	if (!element) return JSON_EMISSINGPARAM;
 
-	/* destroy all the children */
-	if (element->child_head) json_elementDestroy(element->child_head);
+	/* walk the whole lot as one list - children are spliced in ahead of the next sibling,
+	   as recursing along a long array (or down a deep one) would run out of stack */
+	for (; element; element = next) {
+		next = element->sibling_next;
+		if (element->child_head) {
+			json_elementTail(element)->sibling_next = next;
+			next = element->child_head;
+		}
+		if (element->flags & ELEMENT_USERDATA) json_userDataRemove(element);
+		if (element->flags & ELEMENT_INDEXED) json_indexFree(element);
+		json_arenaSpareElement(&element->json->arena, element);
+	}
+
+	return JSON_ENONE;
+}
+
+/* take the element out of its parent's list of children */
+json_err json_elementUnlink(struct json_element *element) {
+	struct json_element *parent;
+
+	if (!element) return JSON_EMISSINGPARAM;
+	parent = element->parent;
+	if (parent && (parent->flags & ELEMENT_INDEXED)) json_indexRemove(parent, element);
+
+	if (parent) parent->child_count--;
+	if (parent && parent->child_head == element) {
+		/* the first child - the next one takes over, along with the pointer to the last */
+		parent->child_head = element->sibling_next;
+		if (element->sibling_next) element->sibling_next->sibling_prev = element->sibling_prev;
+	} else if (element->sibling_prev) {
+		element->sibling_prev->sibling_next = element->sibling_next;
+		if (element->sibling_next) {
+			element->sibling_next->sibling_prev = element->sibling_prev;
+		} else if (parent) {
+			parent->child_head->sibling_prev = element->sibling_prev;
+		}
+	}
+
+	element->parent = NULL;
+	element->sibling_prev = NULL;
+	element->sibling_next = NULL;
+
+	return JSON_ENONE;
+}
+
+/* add 'element' to the end of 'parent's children */
+void json_elementLink(struct json_element *parent, struct json_element *element) {
+	struct json_element *tail;
+
+	element->parent = parent;
+	element->sibling_next = NULL;
+	if ((tail = json_elementTail(parent)) == NULL) {
+		parent->child_head = element;
+	} else {
+		tail->sibling_next = element;
+	}
+	element->sibling_prev = tail ? tail : element;
+	parent->child_head->sibling_prev = element;
+	parent->child_count++;
+	if (parent->flags & ELEMENT_INDEXED) json_indexAdd(parent, element);
+}
 
-	/* remove each sibling from either side */
-	if (element->sibling_prev) {
-		element->sibling_prev->sibling_next = NULL;
-		json_elementDestroy(element->sibling_prev);
+/* put 'element' where 'existing' is, and unlink 'existing' */
+void json_elementReplace(struct json_element *existing, struct json_element *element) {
+	struct json_element *parent;
+
+	parent = existing->parent;
+	if (parent->flags & ELEMENT_INDEXED) json_indexReplace(parent, existing, element);
+	element->parent = parent;
+	element->sibling_next = existing->sibling_next;
+	if (parent->child_head == existing) {
+		parent->child_head = element;
+		/* it was the only child, so it was pointing at itself */
+		element->sibling_prev = (existing->sibling_prev == existing) ? element : existing->sibling_prev;
+	} else {
+		element->sibling_prev = existing->sibling_prev;
+		element->sibling_prev->sibling_next = element;
 	}
 	if (element->sibling_next) {
-		element->sibling_next->sibling_prev = NULL;
-		json_elementDestroy(element->sibling_next);
+		element->sibling_next->sibling_prev = element;
+	} else {
+		parent->child_head->sibling_prev = element;
 	}
 
-	/* finally, destroy us */
-	if (element->name) free(element->name);
-	switch (element->type) {
-		case JSON_STRING:
-		case JSON_FUNCTION:
-			if (element->data.asRaw) free(element->data.asRaw);
-		default:;
+	existing->parent = NULL;
+	existing->sibling_prev = NULL;
+	existing->sibling_next = NULL;
+}
+
+/* throw away the element's value (and everything under it), ready for a new one */
+static json_err json_elementClear(struct json_element *element, enum json_dataTypes type) {
+	if (!element) return JSON_EMISSINGPARAM;
+	/* the root can only be emptied */
+	if (!element->parent && type != JSON_OBJECT && type != JSON_ARRAY) return JSON_EINVAL;
+	/* the parser hasn't found the end of it yet */
+	if ((element->flags & ELEMENT_LAZY) && element->data_len == 0) return JSON_EINCOMPLETE;
+
+	if (element->child_head) json_elementDestroy(element->child_head);
+	element->child_head = NULL;
+	element->child_count = 0;
+	json_indexFree(element);
+	element->flags &= ~(ELEMENT_LAZY | ELEMENT_FAILED | ELEMENT_INLINE | ELEMENT_UNSIGNED);
+	memset(&element->data, 0, sizeof(element->data));
+	element->data_len = 0;
+	element->type = type;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetType(struct json_element *element, enum json_dataTypes *type) {
+	if (!element || !type) return JSON_EMISSINGPARAM;
+	*type = element->type;
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetName(struct json_element *element, unsigned char **name, unsigned int *nameLen) {
+	if (!element || !name || !nameLen) return JSON_EMISSINGPARAM;
+	/* array members (and the root) don't have one */
+	if (!element->name) return JSON_EMISSING;
+
+	*name = element->name;
+	*nameLen = element->name_len;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetBoolean(struct json_element *element, int *data) {
+	if (!element || !data) return JSON_EMISSINGPARAM;
+	if (element->type != JSON_BOOLEAN) return JSON_ETYPEMISMATCH;
+
+	*data = !!element->data.asInt;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetInteger(struct json_element *element, int *data) {
+	if (!element || !data) return JSON_EMISSINGPARAM;
+	if (element->type != JSON_INTEGER) return JSON_ETYPEMISMATCH;
+	if (element->flags & ELEMENT_UNSIGNED) return JSON_ERANGE;
+	if (element->data.asInt64 < INT_MIN || element->data.asInt64 > INT_MAX) return JSON_ERANGE;
+
+	*data = element->data.asInt64;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetInteger64(struct json_element *element, int64_t *data) {
+	if (!element || !data) return JSON_EMISSINGPARAM;
+	if (element->type != JSON_INTEGER) return JSON_ETYPEMISMATCH;
+	if (element->flags & ELEMENT_UNSIGNED) return JSON_ERANGE;
+
+	*data = element->data.asInt64;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetUInteger64(struct json_element *element, uint64_t *data) {
+	if (!element || !data) return JSON_EMISSINGPARAM;
+	if (element->type != JSON_INTEGER) return JSON_ETYPEMISMATCH;
+	if (!(element->flags & ELEMENT_UNSIGNED) && element->data.asInt64 < 0) return JSON_ERANGE;
+
+	*data = element->data.asUInt64;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetFloat(struct json_element *element, double *data) {
+	if (!element || !data) return JSON_EMISSINGPARAM;
+	if (element->type != JSON_FLOAT) return JSON_ETYPEMISMATCH;
+
+	*data = element->data.asFloat;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetString(struct json_element *element, unsigned char **data, unsigned int *dataLen) {
+	if (!element || !data || !dataLen) return JSON_EMISSINGPARAM;
+	if (element->type != JSON_STRING) return JSON_ETYPEMISMATCH;
+
+	*data = json_elementString(element);
+	*dataLen = element->data_len;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetChildCount(struct json_element *element, unsigned int *count) {
+	json_err ret;
+
+	if (!element || !count) return JSON_EMISSINGPARAM;
+	if (element->type != JSON_OBJECT && element->type != JSON_ARRAY) return JSON_ETYPEMISMATCH;
+	if ((ret = json_parseExpand(element)) != JSON_ENONE) return ret;
+
+	*count = element->child_count;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetParent(struct json_element *element, struct json_element **parent) {
+	if (!element || !parent) return JSON_EMISSINGPARAM;
+	if (!element->parent) return JSON_EMISSING;
+	*parent = element->parent;
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetFirstChild(struct json_element *element, struct json_element **child) {
+	json_err ret;
+
+	if (!element || !child) return JSON_EMISSINGPARAM;
+	if ((ret = json_parseExpand(element)) != JSON_ENONE) return ret;
+	if (!element->child_head) return JSON_EMISSING;
+
+	*child = element->child_head;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementGetNext(struct json_element *element, struct json_element **sibling) {
+	if (!element || !sibling) return JSON_EMISSINGPARAM;
+	if (!element->sibling_next) return JSON_EMISSING;
+	*sibling = element->sibling_next;
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementAddChild(struct json_element *parent, const unsigned char *name, unsigned int nameLen, struct json_element **childRet) {
+	json_err ret;
+	struct json_element *child;
+
+	if (!parent) return JSON_EMISSINGPARAM;
+	if ((ret = json_elementAppend(parent, (unsigned char *)name, nameLen, 0, JSON_DUPLICATE_REJECT, &child)) != JSON_ENONE) return ret;
+
+	child->type = JSON_NULL;
+	if (childRet) *childRet = child;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementSetNull(struct json_element *element) {
+	return json_elementClear(element, JSON_NULL);
+}
+
+EXPORT json_err json_elementSetBoolean(struct json_element *element, int data) {
+	json_err ret;
+
+	if ((ret = json_elementClear(element, JSON_BOOLEAN)) != JSON_ENONE) return ret;
+	element->data.asInt = !!data;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementSetInteger64(struct json_element *element, int64_t data) {
+	json_err ret;
+
+	if ((ret = json_elementClear(element, JSON_INTEGER)) != JSON_ENONE) return ret;
+	element->data.asInt64 = data;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementSetUInteger64(struct json_element *element, uint64_t data) {
+	json_err ret;
+
+	if ((ret = json_elementClear(element, JSON_INTEGER)) != JSON_ENONE) return ret;
+	if (data > INT64_MAX) {
+		element->flags |= ELEMENT_UNSIGNED;
+		element->data.asUInt64 = data;
+	} else {
+		element->data.asInt64 = data;
 	}
-	free(element);
-	
+
 	return JSON_ENONE;
 }
 
+EXPORT json_err json_elementSetFloat(struct json_element *element, double data) {
+	json_err ret;
+
+	if ((ret = json_elementClear(element, JSON_FLOAT)) != JSON_ENONE) return ret;
+	element->data.asFloat = data;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementSetString(struct json_element *element, const unsigned char *data, unsigned int dataLen) {
+	json_err ret;
+	unsigned char small[sizeof(element->data.asInline)];
+	unsigned char *copy;
+
+	if (!element || !data) return JSON_EMISSINGPARAM;
+
+	/* copy it before the old value is thrown away - 'data' may well be that value (or
+	   something under it). short ones go inside the element itself */
+	copy = NULL;
+	if (dataLen < sizeof(small)) {
+		memcpy(small, data, dataLen);
+		small[dataLen] = '\0';
+	} else if ((ret = json_arenaCopy(&element->json->arena, data, dataLen, &copy)) != JSON_ENONE) {
+		return ret;
+	}
+
+	if ((ret = json_elementClear(element, JSON_STRING)) != JSON_ENONE) return ret;
+	if (copy) {
+		element->data.asRaw = copy;
+	} else {
+		memcpy(element->data.asInline, small, sizeof(small));
+		element->flags |= ELEMENT_INLINE;
+	}
+	element->data_len = dataLen;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_elementSetObject(struct json_element *element) {
+	return json_elementClear(element, JSON_OBJECT);
+}
+
+EXPORT json_err json_elementSetArray(struct json_element *element) {
+	return json_elementClear(element, JSON_ARRAY);
+}
+
+EXPORT json_err json_elementRemove(struct json_element *element) {
+	if (!element) return JSON_EMISSINGPARAM;
+	/* the root belongs to the document */
+	if (!element->parent) return JSON_EINVAL;
+
+	json_elementUnlink(element);
+
+	/* we are now completely un-linked... destroy us and all our children */
+	return json_elementDestroy(element);
+}
+
+EXPORT json_err json_iteratorInit(struct json_iterator *iterator, struct json_element *parent) {
+	json_err ret;
+
+	if (!iterator || !parent) return JSON_EMISSINGPARAM;
+	if (parent->type != JSON_OBJECT && parent->type != JSON_ARRAY) return JSON_ETYPEMISMATCH;
+	if ((ret = json_parseExpand(parent)) != JSON_ENONE) return ret;
+
+	iterator->next = parent->child_head;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_iteratorNext(struct json_iterator *iterator, struct json_element **childRet, unsigned char **name, unsigned int *nameLen) {
+	struct json_element *child;
+
+	if (!iterator) return JSON_EMISSINGPARAM;
+	if ((child = iterator->next) == NULL) return JSON_EMISSING;
+
+	/* move on now, so that the caller can remove the child that we give them */
+	iterator->next = child->sibling_next;
+
+	if (childRet) *childRet = child;
+	if (name) *name = child->name;
+	if (nameLen) *nameLen = child->name_len;
+
+	return JSON_ENONE;
+}
+
+EXPORT int json_iteratorDone(struct json_iterator *iterator) {
+	return !iterator || !iterator->next;
+}
+
 json_err json_identifyAsArray(unsigned char *identifier, unsigned char **identifierStart, unsigned char **identifierEnd, enum identifierType *idType) {
 	unsigned char *t;
 	unsigned char *startOfWord;
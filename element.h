@@ -20,8 +20,16 @@
 	along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-json_err json_elementNew(struct json_element **element);
+/* the string held by a JSON_STRING element */
+#define json_elementString(e) (((e)->flags & ELEMENT_INLINE) ? (e)->data.asInline : (e)->data.asRaw)
+/* the last child (see struct json_element) */
+#define json_elementTail(e)   ((e)->child_head ? (e)->child_head->sibling_prev : NULL)
+
+json_err json_elementNew(struct json *json, struct json_element **element);
 json_err json_elementDestroy(struct json_element *element);
+json_err json_elementUnlink(struct json_element *element);
+void json_elementLink(struct json_element *parent, struct json_element *element);
+void json_elementReplace(struct json_element *existing, struct json_element *element);
 json_err json_identifyAsArray(unsigned char *identifier, unsigned char **identifierStart, unsigned char **identifierEnd, enum identifierType *idType);
 json_err json_identifyAsElement(unsigned char *identifier, unsigned char **identifierStart, unsigned char **identifierEnd, enum identifierType *idType);
 
@@ -23,14 +23,16 @@
 
 #include "json_int.h"
 #include "get.h"
+#include "path.h"
 #include "element.h"
+#include "parse.h"
 
-EXPORT json_err json_getType(struct json_element *root, unsigned char *identifier, enum json_dataTypes *type) {
+static json_err json_getTypeAt(struct json_element *root, unsigned char *identifier, struct json_path *path, enum json_dataTypes *type) {
 	json_err ret;
 	struct json_element *target;
 
-	if (!root || !identifier) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
+	if (!root || (!identifier && !path)) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
 	if (!target) return JSON_EMISSING;
 
 	if (type) *type = target->type;
@@ -38,7 +40,15 @@ EXPORT json_err json_getType(struct json_element *root, unsigned char *identifie
 	return JSON_ENONE;
 }
 
-EXPORT json_err json_getChildren(struct json_element *root, unsigned char *identifier, unsigned char ***childrenRet) {
+EXPORT json_err json_getType(struct json_element *root, unsigned char *identifier, enum json_dataTypes *type) {
+	return json_getTypeAt(root, identifier, NULL, type);
+}
+
+EXPORT json_err json_getTypePath(struct json_element *root, struct json_path *path, enum json_dataTypes *type) {
+	return json_getTypeAt(root, NULL, path, type);
+}
+
+static json_err json_getChildrenAt(struct json_element *root, unsigned char *identifier, struct json_path *path, unsigned char ***childrenRet) {
 	json_err ret;
 	struct json_element *target;
 	struct json_element *child, *cFirst;
@@ -48,20 +58,19 @@ EXPORT json_err json_getChildren(struct json_element *root, unsigned char *ident
 	unsigned char **cList;
 	unsigned char *cName;
 
-	if (!root || !identifier) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
+	if (!root || (!identifier && !path)) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
 	if (!target) return JSON_EMISSING;
+	if ((ret = json_parseExpand(target)) != JSON_ENONE) return ret;
 
-	/* locate the left most child */
-	for (child = target->child_head; child && child->sibling_prev; child = child->sibling_prev);
-	if (!child) return JSON_EMISSING;
+	if ((child = target->child_head) == NULL) return JSON_EMISSING;
 	cFirst = child;
 
 	memSize = 0;
 	for (i = 0; child; child = child->sibling_next) {
 		if (!child->name) continue;
 		memSize += sizeof(char *);
-		memSize += sizeof(char) * (strlen(child->name) + 1);
+		memSize += sizeof(char) * (child->name_len + 1);
 		i++;
 	}
 	memSize += sizeof(char *);
@@ -72,8 +81,9 @@ EXPORT json_err json_getChildren(struct json_element *root, unsigned char *ident
 	for (i = 0, child = cFirst; child; child = child->sibling_next) {
 		if (!child->name) continue;
 		cList[i] = cName;
-		strcpy(cName, child->name);
-		cName += strlen(cName) + 1;
+		memcpy(cName, child->name, child->name_len);
+		cName[child->name_len] = '\0';
+		cName += child->name_len + 1;
 		i++;
 	}
 	cList[i] = NULL;
@@ -83,89 +93,155 @@ EXPORT json_err json_getChildren(struct json_element *root, unsigned char *ident
 	return JSON_ENONE;
 }
 
-EXPORT json_err json_getBoolean(struct json_element *root, unsigned char *identifier, int *data) {
+EXPORT json_err json_getChildren(struct json_element *root, unsigned char *identifier, unsigned char ***childrenRet) {
+	return json_getChildrenAt(root, identifier, NULL, childrenRet);
+}
+
+EXPORT json_err json_getChildrenPath(struct json_element *root, struct json_path *path, unsigned char ***childrenRet) {
+	return json_getChildrenAt(root, NULL, path, childrenRet);
+}
+
+static json_err json_getBooleanAt(struct json_element *root, unsigned char *identifier, struct json_path *path, int *data) {
 	json_err ret;
 	struct json_element *target;
 
-	if (!root || !identifier || !data) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
-	if (!target) return JSON_EMISSING;
-	if (target->type != JSON_BOOLEAN) return JSON_ETYPEMISMATCH;
+	if (!root || (!identifier && !path) || !data) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
 
-	*data = !!target->data.asInt;
+	return json_elementGetBoolean(target, data);
+}
 
-	return JSON_ENONE;
+EXPORT json_err json_getBoolean(struct json_element *root, unsigned char *identifier, int *data) {
+	return json_getBooleanAt(root, identifier, NULL, data);
+}
+
+EXPORT json_err json_getBooleanPath(struct json_element *root, struct json_path *path, int *data) {
+	return json_getBooleanAt(root, NULL, path, data);
+}
+
+static json_err json_getIntegerAt(struct json_element *root, unsigned char *identifier, struct json_path *path, int *data) {
+	json_err ret;
+	struct json_element *target;
+
+	if (!root || (!identifier && !path) || !data) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
+
+	return json_elementGetInteger(target, data);
 }
 
 EXPORT json_err json_getInteger(struct json_element *root, unsigned char *identifier, int *data) {
+	return json_getIntegerAt(root, identifier, NULL, data);
+}
+
+EXPORT json_err json_getIntegerPath(struct json_element *root, struct json_path *path, int *data) {
+	return json_getIntegerAt(root, NULL, path, data);
+}
+
+static json_err json_getInteger64At(struct json_element *root, unsigned char *identifier, struct json_path *path, int64_t *data) {
 	json_err ret;
 	struct json_element *target;
 
-	if (!root || !identifier || !data) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
-	if (!target) return JSON_EMISSING;
-	if (target->type != JSON_INTEGER) return JSON_ETYPEMISMATCH;
+	if (!root || (!identifier && !path) || !data) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
+
+	return json_elementGetInteger64(target, data);
+}
 
-	*data = target->data.asInt;
+EXPORT json_err json_getInteger64(struct json_element *root, unsigned char *identifier, int64_t *data) {
+	return json_getInteger64At(root, identifier, NULL, data);
+}
 
-	return JSON_ENONE;
+EXPORT json_err json_getInteger64Path(struct json_element *root, struct json_path *path, int64_t *data) {
+	return json_getInteger64At(root, NULL, path, data);
 }
 
-EXPORT json_err json_getFloat(struct json_element *root, unsigned char *identifier, double *data) {
+static json_err json_getUInteger64At(struct json_element *root, unsigned char *identifier, struct json_path *path, uint64_t *data) {
 	json_err ret;
 	struct json_element *target;
 
-	if (!root || !identifier || !data) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
-	if (!target) return JSON_EMISSING;
-	if (target->type != JSON_FLOAT) return JSON_ETYPEMISMATCH;
+	if (!root || (!identifier && !path) || !data) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
 
-	*data = target->data.asFloat;
+	return json_elementGetUInteger64(target, data);
+}
 
-	return JSON_ENONE;
+EXPORT json_err json_getUInteger64(struct json_element *root, unsigned char *identifier, uint64_t *data) {
+	return json_getUInteger64At(root, identifier, NULL, data);
 }
 
-EXPORT json_err json_getString(struct json_element *root, unsigned char *identifier, unsigned char **data, unsigned int *dataLen) {
+EXPORT json_err json_getUInteger64Path(struct json_element *root, struct json_path *path, uint64_t *data) {
+	return json_getUInteger64At(root, NULL, path, data);
+}
+
+static json_err json_getFloatAt(struct json_element *root, unsigned char *identifier, struct json_path *path, double *data) {
 	json_err ret;
 	struct json_element *target;
 
-	if (!root || !identifier || !data || !dataLen) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
-	if (!target) return JSON_EMISSING;
-	if (target->type != JSON_STRING) return JSON_ETYPEMISMATCH;
+	if (!root || (!identifier && !path) || !data) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
 
-	*data = target->data.asRaw;
-	*dataLen = target->data_len;
+	return json_elementGetFloat(target, data);
+}
 
-	return JSON_ENONE;
+EXPORT json_err json_getFloat(struct json_element *root, unsigned char *identifier, double *data) {
+	return json_getFloatAt(root, identifier, NULL, data);
+}
+
+EXPORT json_err json_getFloatPath(struct json_element *root, struct json_path *path, double *data) {
+	return json_getFloatAt(root, NULL, path, data);
+}
+
+static json_err json_getStringAt(struct json_element *root, unsigned char *identifier, struct json_path *path, unsigned char **data, unsigned int *dataLen) {
+	json_err ret;
+	struct json_element *target;
+
+	if (!root || (!identifier && !path) || !data || !dataLen) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
+
+	return json_elementGetString(target, data, dataLen);
+}
+
+EXPORT json_err json_getString(struct json_element *root, unsigned char *identifier, unsigned char **data, unsigned int *dataLen) {
+	return json_getStringAt(root, identifier, NULL, data, dataLen);
+}
+
+EXPORT json_err json_getStringPath(struct json_element *root, struct json_path *path, unsigned char **data, unsigned int *dataLen) {
+	return json_getStringAt(root, NULL, path, data, dataLen);
 }
 
 EXPORT json_err json_getFunction(struct json_element *root, unsigned char *identifier, unsigned char **data, unsigned int *dataLen) {
 	return JSON_ENOTIMPLEMENTED;
 }
 
-EXPORT json_err json_getArrayLen(struct json_element *root, unsigned char *identifier, unsigned int *length) {
+static json_err json_getArrayLenAt(struct json_element *root, unsigned char *identifier, struct json_path *path, unsigned int *length) {
 	json_err ret;
 	struct json_element *target;
-	struct json_element *child;
 
-	if (!root || !identifier || !length) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
+	if (!root || (!identifier && !path) || !length) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
 	if (!target) return JSON_EMISSING;
 	if (target->type != JSON_ARRAY) return JSON_ETYPEMISMATCH;
+	if ((ret = json_parseExpand(target)) != JSON_ENONE) return ret;
 
-	for (child = target->child_head; child && child->sibling_prev; child = child->sibling_prev);
-	for ((*length) = 0; child; (*length)++, child = child->sibling_next);
+	*length = target->child_count;
 
 	return JSON_ENONE;
 }
 
-EXPORT json_err json_getArray(struct json_element *root, unsigned char *identifier, struct json_element **targetRet) {
+EXPORT json_err json_getArrayLen(struct json_element *root, unsigned char *identifier, unsigned int *length) {
+	return json_getArrayLenAt(root, identifier, NULL, length);
+}
+
+EXPORT json_err json_getArrayLenPath(struct json_element *root, struct json_path *path, unsigned int *length) {
+	return json_getArrayLenAt(root, NULL, path, length);
+}
+
+static json_err json_getArrayAt(struct json_element *root, unsigned char *identifier, struct json_path *path, struct json_element **targetRet) {
 	json_err ret;
 	struct json_element *target;
 
-	if (!root || !identifier || !targetRet) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
+	if (!root || (!identifier && !path) || !targetRet) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
 	if (!target) return JSON_EMISSING;
 	if (target->type != JSON_ARRAY) return JSON_ETYPEMISMATCH;
 
@@ -174,12 +250,20 @@ EXPORT json_err json_getArray(struct json_element *root, unsigned char *identifi
 	return JSON_ENONE;
 }
 
-EXPORT json_err json_getObject(struct json_element *root, unsigned char *identifier, struct json_element **targetRet) {
+EXPORT json_err json_getArray(struct json_element *root, unsigned char *identifier, struct json_element **targetRet) {
+	return json_getArrayAt(root, identifier, NULL, targetRet);
+}
+
+EXPORT json_err json_getArrayPath(struct json_element *root, struct json_path *path, struct json_element **targetRet) {
+	return json_getArrayAt(root, NULL, path, targetRet);
+}
+
+static json_err json_getObjectAt(struct json_element *root, unsigned char *identifier, struct json_path *path, struct json_element **targetRet) {
 	json_err ret;
 	struct json_element *target;
 
-	if (!root || !identifier || !targetRet) return JSON_EMISSINGPARAM;
-	if ((ret = json_getElement(root, identifier, &target)) != JSON_ENONE) return ret;
+	if (!root || (!identifier && !path) || !targetRet) return JSON_EMISSINGPARAM;
+	if ((ret = json_getTarget(root, identifier, path, &target)) != JSON_ENONE) return ret;
 	if (!target) return JSON_EMISSING;
 	if (target->type != JSON_OBJECT) return JSON_ETYPEMISMATCH;
 
@@ -188,103 +272,38 @@ EXPORT json_err json_getObject(struct json_element *root, unsigned char *identif
 	return JSON_ENONE;
 }
 
+EXPORT json_err json_getObject(struct json_element *root, unsigned char *identifier, struct json_element **targetRet) {
+	return json_getObjectAt(root, identifier, NULL, targetRet);
+}
+
+EXPORT json_err json_getObjectPath(struct json_element *root, struct json_path *path, struct json_element **targetRet) {
+	return json_getObjectAt(root, NULL, path, targetRet);
+}
+
 json_err json_getElement(struct json_element *root, unsigned char *identifier, struct json_element **targetRet) {
 	json_err ret;
-	unsigned char *identifierStart, *identifierEnd;
-	enum identifierType idType;
-	unsigned char *t;
-	struct json_element *target;
+	struct json_pathSegment segment;
+	unsigned char *next;
 
 	if (!root || !identifier) return JSON_EMISSINGPARAM;
-	
-	/* skip over the white space */
-	for (t = identifier; *t == ' '; t++);
-	
-	if (*t == '\0') {
-		if (targetRet) *targetRet = root;
-		return JSON_ENONE;
-	} else if (*t == '[') { /* handle the array identifier */
-		/* for simplicity, this will not resolve strings or floating point numbers, it will ONLY handle positive integer indexes
-		   if you want to dig into an object, then use a freaking dot */
-		unsigned int index;
-		
-		t++;
-		
-		if ((ret = json_identifyAsArray(t, &identifierStart, &identifierEnd, &idType)) != JSON_ENONE) return ret;
-		
-		switch (idType) {
-			case ID_INVALID: return JSON_EINVAL;
-			
-			case ID_NUMBER: { /* simple offset, counting from zero being the left-most sibling */
-				unsigned int ret;
-				unsigned char *pIndex;
-				unsigned char *q;
-
-				/* make space */
-				if ((pIndex = malloc(sizeof(*pIndex) * (identifierEnd - identifierStart + 2))) == NULL) return JSON_ENOMEM;
-				
-				/* copy the string in, and terminate */
-				for (t = identifierStart, q = pIndex; t <= identifierEnd; *q = *t, t++, q++);
-				*q = '\0';
-				
-				/* try to pull out the integer */
-				ret = sscanf((char *)pIndex, "%u", &index);
-				free(pIndex);
-				if (ret != 1) return JSON_EINVAL;
-				
-				break;
-			}
-			case ID_IDENTIFIER: /* needs to be evaluated... */
-#warning TODO - for simplicity im pretending that this path doesnt exist... maybe later
-				return JSON_ENOTIMPLEMENTED;
-				break;
-		}
-
-		/* find the left-most sibling */
-		for (target = root->child_head; target && target->sibling_prev; target = target->sibling_prev);
-		/* iterate to the indexed child */
-		for (; index > 0 && target; index--, target = target->sibling_next);
-		
-		/* check that we actually found something */
-		if (index != 0) return JSON_EMISSING;
-		if (*identifierEnd != '\0') identifierEnd++;
-		
-	} else {
-		if ((ret = json_identifyAsElement(t, &identifierStart, &identifierEnd, &idType)) != JSON_ENONE) return ret;
-		
-		/* find the left-most child */
-		for (target = root->child_head; target && target->sibling_prev; target = target->sibling_prev);
-		
-		/* find the named sibling */
-		for (; target; target = target->sibling_next) {
-			unsigned char *q, *p;
-			
-			/* skip items with no name... */
-			if (!target->name) continue;
-			
-			/* compare the names */
-			for (q = identifierStart, p = target->name; q <= identifierEnd && *q == *p; q++, p++);
-
-			/* check that the match was valid (full against full) */
-			if (q == identifierEnd + 1 && *p == '\0') break;
-		}
-	}
-	
-	/* check that we actually found something */
-	if (!target) return JSON_EMISSING;
-	
-	/* now that we are done with the identifier, move it along before passing it on */
-	if (*identifierEnd != '\0') identifierEnd++;
-	if (*identifierEnd != '\0' && *identifierEnd == '.') identifierEnd++;
 
-	/* if we haven't run through all of the identifiers, then continue! */
-	if (*identifierEnd != '\0') {
-		return json_getElement(target, identifierEnd, targetRet);
+	/* go down one segment at a time, reading each one as we get to it */
+	for (;;) {
+		if ((ret = json_pathNext(identifier, &segment, &next)) != JSON_ENONE) return ret;
+		if (!next) break;
+		if ((ret = json_pathStep(root, &segment, &root)) != JSON_ENONE) return ret;
+		identifier = next;
 	}
 
 	/* return the target if they wanted it */
-	if (targetRet) *targetRet = target;
+	if (targetRet) *targetRet = root;
 
 	return JSON_ENONE;
 }
 
+/* find the target of either 'identifier', or a 'path' from json_pathCompile() */
+json_err json_getTarget(struct json_element *root, unsigned char *identifier, struct json_path *path, struct json_element **targetRet) {
+	if (path) return json_pathElement(root, path, targetRet);
+	return json_getElement(root, identifier, targetRet);
+}
+
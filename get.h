@@ -21,5 +21,6 @@
 */
 
 json_err json_getElement(struct json_element *root, unsigned char *identifier, struct json_element **targetRet);
+json_err json_getTarget(struct json_element *root, unsigned char *identifier, struct json_path *path, struct json_element **targetRet);
 
 #endif /* __GET_H */
@@ -0,0 +1,201 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_int.h"
+#include "index.h"
+#include "intern.h"
+
+static void json_indexInsert(struct json_index *index, uint32_t hash, struct json_element *child) {
+	unsigned int i;
+
+	for (i = hash & (index->len - 1); index->slots[i].element; i = (i + 1) & (index->len - 1));
+	index->slots[i].hash = hash;
+	index->slots[i].element = child;
+	index->count++;
+}
+
+/* (re)build the index for 'parent' from its children, leaving room for as many again */
+static json_err json_indexMake(struct json_element *parent) {
+	json_err ret;
+	struct json *json;
+	struct json_element *child;
+	struct json_index *index;
+	struct json_vector *vector;
+	void *new, *old;
+	unsigned int len;
+
+	json = parent->json;
+
+	if (parent->type == JSON_ARRAY) {
+		for (len = 64; len < parent->child_count * 2; len *= 2);
+		if ((vector = json_alloc(&json->allocator, sizeof(*vector) + sizeof(*vector->elements) * len)) == NULL) return JSON_ENOMEM;
+		vector->len = len;
+		vector->count = 0;
+		for (child = parent->child_head; child; child = child->sibling_next) {
+			vector->elements[vector->count++] = child;
+		}
+		new = vector;
+	} else {
+		/* an index is never more than half full */
+		for (len = 64; len < parent->child_count * 4; len *= 2);
+		if ((index = json_alloc(&json->allocator, sizeof(*index) + sizeof(*index->slots) * len)) == NULL) return JSON_ENOMEM;
+		memset(index, 0, sizeof(*index) + sizeof(*index->slots) * len);
+		index->len = len;
+		/* in order, so that when names repeat (JSON_DUPLICATE_TRUST) the first one is found first */
+		for (child = parent->child_head; child; child = child->sibling_next) {
+			json_indexInsert(index, json_internNameHash(child), child);
+		}
+		new = index;
+	}
+
+	old = (parent->flags & ELEMENT_INDEXED) ? json_mapGet(&json->indexes, parent) : NULL;
+	if ((ret = json_mapSet(&json->allocator, &json->indexes, parent, new)) != JSON_ENONE) {
+		json_free(&json->allocator, new);
+		return ret;
+	}
+	json_free(&json->allocator, old);
+	parent->flags |= ELEMENT_INDEXED;
+
+	return JSON_ENONE;
+}
+
+json_err json_indexBuild(struct json_element *parent) {
+	if (!parent) return JSON_EMISSINGPARAM;
+	if (parent->type != JSON_OBJECT && parent->type != JSON_ARRAY) return JSON_ETYPEMISMATCH;
+	return json_indexMake(parent);
+}
+
+struct json_element *json_indexFind(struct json_element *object, const unsigned char *name, unsigned int nameLen, uint32_t hash) {
+	struct json_index *index;
+	struct json_element *child;
+	unsigned int i;
+
+	index = json_mapGet(&object->json->indexes, object);
+	for (i = hash & (index->len - 1); (child = index->slots[i].element) != NULL; i = (i + 1) & (index->len - 1)) {
+		if (index->slots[i].hash != hash || child->name_len != nameLen) continue;
+		if (child->name == name || !memcmp(child->name, name, nameLen)) return child;
+	}
+
+	return NULL;
+}
+
+/* 'child' has just been linked to the end of 'parent'. if the index can't grow, it's
+   dropped, and the children will be gone through one by one until it is built again */
+void json_indexAdd(struct json_element *parent, struct json_element *child) {
+	struct json_index *index;
+	struct json_vector *vector;
+
+	if (parent->type == JSON_ARRAY) {
+		vector = json_mapGet(&parent->json->indexes, parent);
+		if (vector->count < vector->len) {
+			vector->elements[vector->count++] = child;
+			return;
+		}
+	} else {
+		index = json_mapGet(&parent->json->indexes, parent);
+		if ((index->count + 1) * 2 <= index->len) {
+			json_indexInsert(index, json_internNameHash(child), child);
+			return;
+		}
+	}
+
+	/* the child is already linked, so it'll be picked up */
+	if (json_indexMake(parent) != JSON_ENONE) json_indexFree(parent);
+}
+
+/* 'child' is about to be unlinked from 'parent' */
+void json_indexRemove(struct json_element *parent, struct json_element *child) {
+	struct json_index *index;
+	struct json_vector *vector;
+	struct json_indexSlot *s;
+	unsigned int i, j, k, mask;
+
+	if (parent->type == JSON_ARRAY) {
+		/* taking the last one off is easy. from anywhere else, everything after it would
+		   have to move down - drop the vector instead, and build it again when it's needed */
+		vector = json_mapGet(&parent->json->indexes, parent);
+		if (vector->count && vector->elements[vector->count - 1] == child) {
+			vector->count--;
+		} else {
+			json_indexFree(parent);
+		}
+		return;
+	}
+
+	index = json_mapGet(&parent->json->indexes, parent);
+	s = index->slots;
+	mask = index->len - 1;
+
+	for (i = json_internNameHash(child) & mask; s[i].element && s[i].element != child; i = (i + 1) & mask);
+	if (!s[i].element) return;
+	s[i].element = NULL;
+	index->count--;
+
+	/* close the gap - pull back anything after it that would no longer be found */
+	for (j = (i + 1) & mask; s[j].element; j = (j + 1) & mask) {
+		k = s[j].hash & mask;
+		/* is its home slot cyclically in (i, j]? then it can stay */
+		if ((i < j) ? (i < k && k <= j) : (i < k || k <= j)) continue;
+		s[i] = s[j];
+		s[j].element = NULL;
+		i = j;
+	}
+}
+
+/* 'element' is about to take the place of 'existing' */
+void json_indexReplace(struct json_element *parent, struct json_element *existing, struct json_element *element) {
+	struct json_vector *vector;
+	unsigned int i;
+
+	if (parent->type == JSON_ARRAY) {
+		vector = json_mapGet(&parent->json->indexes, parent);
+		for (i = 0; i < vector->count && vector->elements[i] != existing; i++);
+		if (i < vector->count) vector->elements[i] = element;
+		return;
+	}
+
+	/* where it is in the list doesn't matter to an object's index */
+	json_indexRemove(parent, existing);
+	json_indexInsert(json_mapGet(&parent->json->indexes, parent), json_internNameHash(element), element);
+}
+
+void json_indexFree(struct json_element *parent) {
+	struct json *json;
+
+	if (!(parent->flags & ELEMENT_INDEXED)) return;
+	json = parent->json;
+	json_free(&json->allocator, json_mapGet(&json->indexes, parent));
+	json_mapRemove(&json->indexes, parent);
+	parent->flags &= ~ELEMENT_INDEXED;
+}
+
+/* give back every index at once - the elements are being thrown away too, so they aren't
+   touched (the root needs ELEMENT_INDEXED clearing by hand) */
+void json_indexFreeAll(struct json *json) {
+	unsigned int i;
+
+	for (i = 0; json->indexes.count && i < json->indexes.len; i++) {
+		if (json->indexes.entries[i].element) json_free(&json->allocator, json->indexes.entries[i].data);
+	}
+	json_mapClear(&json->indexes);
+}
@@ -0,0 +1,60 @@
+#ifndef __INDEX_H
+#define __INDEX_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* objects / arrays with at least this many children get an index the first time that
+   one of them is looked for by name / position (see json_setIndexWidth()) */
+#define JSON_INDEX_WIDTH 32
+
+struct json_indexSlot {
+	uint32_t hash; /* json_internNameHash() of the element */
+	struct json_element *element;
+};
+
+/* the children of an object, by name. open addressing, never more than half full. the
+   children themselves stay where they are, so they are still printed in order */
+struct json_index {
+	unsigned int len; /* a power of 2 */
+	unsigned int count;
+	struct json_indexSlot slots[];
+};
+
+/* the children of an array, in order */
+struct json_vector {
+	unsigned int len;
+	unsigned int count;
+	struct json_element *elements[];
+};
+
+/* these all take either an object or an array */
+json_err json_indexBuild(struct json_element *parent);
+void json_indexAdd(struct json_element *parent, struct json_element *child);
+void json_indexRemove(struct json_element *parent, struct json_element *child);
+void json_indexReplace(struct json_element *parent, struct json_element *existing, struct json_element *element);
+void json_indexFree(struct json_element *parent);
+
+struct json_element *json_indexFind(struct json_element *object, const unsigned char *name, unsigned int nameLen, uint32_t hash);
+#define json_indexChild(array, n) (((struct json_vector *)json_mapGet(&(array)->json->indexes, (array)))->elements[(n)])
+
+void json_indexFreeAll(struct json *json);
+
+#endif /* __INDEX_H */
@@ -0,0 +1,96 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_int.h"
+#include "intern.h"
+
+/* FNV-1a - names are short, so this is hard to beat */
+uint32_t json_internHash(const unsigned char *name, unsigned int len) {
+	uint32_t hash;
+	unsigned int i;
+
+	for (hash = 2166136261u, i = 0; i < len; i++) {
+		hash = (hash ^ name[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+/* where a name with this hash and length is, or should go, in the table */
+static unsigned int json_internSlot(struct json *json, const unsigned char *name, unsigned int len, uint32_t hash) {
+	unsigned int i;
+	struct json_internName *h;
+
+	for (i = hash & (json->internLen - 1); json->intern[i]; i = (i + 1) & (json->internLen - 1)) {
+		h = json_internHeader(json->intern[i]);
+		if (h->hash == hash && h->len == len && !memcmp(json->intern[i], name, len)) break;
+	}
+
+	return i;
+}
+
+/* find the document's copy of 'name', making one (in the arena) if there isn't one yet */
+json_err json_intern(struct json *json, const unsigned char *name, unsigned int len, uint32_t hash, unsigned char **interned) {
+	json_err ret;
+	unsigned char **old, **new;
+	unsigned int i, oldLen, newLen;
+	struct json_internName *h;
+
+	/* keep it no more than half full */
+	if ((json->internCount + 1) * 2 > json->internLen) {
+		newLen = json->internLen ? json->internLen * 2 : 64;
+		if ((new = json_alloc(&json->allocator, sizeof(*new) * newLen)) == NULL) return JSON_ENOMEM;
+		memset(new, 0, sizeof(*new) * newLen);
+		old = json->intern;
+		oldLen = json->internLen;
+		json->intern = new;
+		json->internLen = newLen;
+		for (i = 0; i < oldLen; i++) {
+			if (!old[i]) continue;
+			h = json_internHeader(old[i]);
+			json->intern[json_internSlot(json, old[i], h->len, h->hash)] = old[i];
+		}
+		json_free(&json->allocator, old);
+	}
+
+	i = json_internSlot(json, name, len, hash);
+	if (!json->intern[i]) {
+		if ((ret = json_arenaAlloc(&json->arena, sizeof(*h) + len + 1, (void **)&h)) != JSON_ENONE) return ret;
+		h->hash = hash;
+		h->len = len;
+		memcpy(&h[1], name, len);
+		((unsigned char *)&h[1])[len] = '\0';
+		json->intern[i] = (unsigned char *)&h[1];
+		json->internCount++;
+	}
+	*interned = json->intern[i];
+
+	return JSON_ENONE;
+}
+
+/* forget every name - for when the arena that they live in is being reset */
+void json_internReset(struct json *json) {
+	if (!json->internCount) return;
+	memset(json->intern, 0, sizeof(*json->intern) * json->internLen);
+	json->internCount = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef __INTERN_H
+#define __INTERN_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* every interned name is stored straight after one of these, so an element's name can
+   be checked against a hash (see ELEMENT_INTERNED) before looking at the bytes */
+struct json_internName {
+	uint32_t hash;
+	unsigned int len;
+};
+#define json_internHeader(name) ((struct json_internName *)(name) - 1)
+
+uint32_t json_internHash(const unsigned char *name, unsigned int len);
+/* the hash of an element's name, without working it out again if it's interned */
+#define json_internNameHash(e) (((e)->flags & ELEMENT_INTERNED) ? json_internHeader((e)->name)->hash : json_internHash((e)->name, (e)->name_len))
+json_err json_intern(struct json *json, const unsigned char *name, unsigned int len, uint32_t hash, unsigned char **interned);
+void json_internReset(struct json *json);
+
+#endif /* __INTERN_H */
@@ -20,21 +20,36 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #include "json_int.h"
 #include "element.h"
+#include "project.h"
+#include "intern.h"
+#include "index.h"
 
 EXPORT json_err json_new(struct json **jsonRet, struct json_element **rootRet) {
-	json_err ret;
+	return json_newWithAllocator(jsonRet, rootRet, NULL);
+}
+
+EXPORT json_err json_newWithAllocator(struct json **jsonRet, struct json_element **rootRet, const struct json_allocator *allocator) {
 	struct json *json;
 	struct json_element *root;
 
 	if (!jsonRet) return JSON_EMISSINGPARAM;
+	if (!allocator) allocator = &json_allocDefault;
+	if (!allocator->alloc || !allocator->realloc || !allocator->free) return JSON_EMISSINGPARAM;
 
-	if ((ret = json_elementNew(&root)) != JSON_ENONE) return ret;
-	if ((json = malloc(sizeof(*json))) == NULL) return JSON_ENOMEM;
+	if ((json = json_alloc(allocator, sizeof(*json))) == NULL) return JSON_ENOMEM;
 	memset(json, 0, sizeof(*json));
+	json->allocator = *allocator;
+	json->arena.allocator = &json->allocator;
+	json->parse.buf.allocator = &json->allocator;
+	json->parse.scan.allocator = &json->allocator;
+	json->parse.stack.allocator = &json->allocator;
+	json->parse.levels.allocator = &json->allocator;
 	json->parse.err = JSON_ENONE;
+	root = &json->rootElement;
 	json->root = root;
 	root->json = json;
 	root->type = JSON_OBJECT;
@@ -46,12 +61,70 @@ EXPORT json_err json_new(struct json **jsonRet, struct json_element **rootRet) {
 }
 
 EXPORT json_err json_destroy(struct json *json) {
+	struct json_allocator allocator;
+
 	if (!json) return JSON_EMISSINGPARAM;
+	allocator = json->allocator;
 	
-	if (json->parse.buf.data) free(json->parse.buf.data);
-	if (json->root) json_elementDestroy(json->root);
+	/* every element, name and string goes in one go */
+	json_arenaFree(&json->arena);
+	if (json->parse.buf.data && (json->parse.flags & PARSE_MAPPED)) {
+		munmap(json->parse.buf.data, json->parse.buf.len);
+	} else if (json->parse.buf.data && (!(json->parse.flags & PARSE_BORROW) || (json->parse.flags & PARSE_ADOPT))) {
+		json_free(&allocator, json->parse.buf.data);
+	}
+	json_scanFree(&json->parse.scan);
+	json_free(&allocator, json->parse.stack.data);
+	json_free(&allocator, json->parse.levels.data);
+	json_mapFree(&allocator, &json->userData);
+	json_indexFreeAll(json);
+	json_mapFree(&allocator, &json->indexes);
+	json_free(&allocator, json->intern);
+	json_projectionFree(&allocator, json->parse.projection);
 	
-	free(json);
+	json_free(&allocator, json);
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_reset(struct json *json) {
+	struct json_parse *p;
+	struct json_element *root;
+
+	if (!json) return JSON_EMISSINGPARAM;
+	p = &json->parse;
+	root = json->root;
+
+	/* the caller's data (or the file) isn't ours to keep, but our own buffer is */
+	if (p->buf.data && (p->flags & PARSE_MAPPED)) {
+		munmap(p->buf.data, p->buf.len);
+	} else if (p->buf.data && (p->flags & PARSE_ADOPT)) {
+		json_free(&json->allocator, p->buf.data);
+	}
+	if (p->flags & PARSE_BORROW) {
+		p->buf.data = NULL;
+		p->buf.len = 0;
+	}
+	p->flags &= ~(PARSE_BORROW | PARSE_ADOPT | PARSE_MAPPED | PARSE_ARRAYROOT);
+	p->buf.pos = 0;
+	p->stack.pos = 0;
+	p->levels.pos = 0;
+	json_scanReset(&p->scan);
+	p->pos = 0;
+	p->err = JSON_ENONE;
+	memset(&p->state, 0, sizeof(p->state));
+	memset(&p->skip, 0, sizeof(p->skip));
+
+	/* every element, name and string goes, but the chunks that they were in stay */
+	json_arenaRewind(&json->arena);
+	json_mapClear(&json->userData);
+	json_indexFreeAll(json);
+	json_internReset(json);
+
+	memset(root, 0, sizeof(*root));
+	root->json = json;
+	root->type = JSON_OBJECT;
+	p->element = root;
 
 	return JSON_ENONE;
 }
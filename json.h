@@ -20,12 +20,18 @@
 	along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifndef EXPORT
 #define EXPORT
 #endif
 
 struct json;
 struct json_element;
+struct json_path;
+struct json_batch;
+struct json_query;
 
 enum json_errors {
 	JSON_ENONE = 0,	
@@ -47,6 +53,10 @@ enum json_errors {
 
 	JSON_EEXISTS = -11,
 	JSON_ENOROOT = -12,
+
+	/* the value is there, but won't fit in the type that you asked for (or, while parsing,
+	   a number is too big for even a double, e.g: 1e400) */
+	JSON_ERANGE = -13,
 };
 typedef enum json_errors json_err;
 
@@ -63,15 +73,132 @@ enum json_dataTypes {
 	JSON_ARRAY,
 };
 
+/* what the parser should do when an object contains the same name more than once */
+enum json_duplicatePolicy {
+	JSON_DUPLICATE_REJECT = 0, /* fail with JSON_EEXISTS (the default) */
+	JSON_DUPLICATE_REPLACE,    /* the last one wins, but keeps the first one's place */
+	JSON_DUPLICATE_TRUST,      /* don't check - the input is known not to repeat names */
+};
+
+/* for parsing without building a tree - see json_setCallbacks().
+   any of these may be NULL. names and strings are only valid until the callback returns,
+   and are not terminated. returning anything other than JSON_ENONE stops the parse, and
+   json_dataAdd() will return that error */
+struct json_callbacks {
+	json_err (*onObjectStart)(void *ctx);
+	json_err (*onObjectEnd)  (void *ctx);
+	json_err (*onArrayStart) (void *ctx);
+	json_err (*onArrayEnd)   (void *ctx);
+	/* called before each value that is inside an object */
+	json_err (*onKey)        (void *ctx, const unsigned char *name, unsigned int nameLen);
+	json_err (*onString)     (void *ctx, const unsigned char *data, unsigned int dataLen);
+	json_err (*onInteger64)  (void *ctx, int64_t data);
+	/* integers above INT64_MAX - if this is NULL, they are given to onFloat() instead */
+	json_err (*onUInteger64) (void *ctx, uint64_t data);
+	json_err (*onFloat)      (void *ctx, double data);
+	json_err (*onBoolean)    (void *ctx, int data);
+	json_err (*onNull)       (void *ctx);
+};
+
+/* each document keeps its elements, names and strings together in an arena, and gives them
+   all back at once in json_destroy(). deleted elements are reused by the document, but their
+   names and strings (and any string that is replaced, e.g: by json_elementSetString()) stay
+   in the arena until json_reset() or json_destroy() - a document that is changed over and
+   over keeps growing */
 EXPORT json_err json_new        (struct json **json, struct json_element **root);
+
+/* where a document gets its memory from - see json_newWithAllocator() */
+struct json_allocator {
+	void *(*alloc)  (void *ctx, size_t size);
+	void *(*realloc)(void *ctx, void *ptr, size_t size);
+	void  (*free)   (void *ctx, void *ptr);
+	void *ctx;
+};
+
+/* like json_new(), but everything that is allocated for the document (including the
+   struct json itself) comes from 'allocator', which is copied. json_dataAdopt() buffers
+   are given back to it too. json_dataParallel() will call it from several threads at once.
+   the buffers returned by json_print() and json_getChildren() still come from malloc(), as
+   the caller free()s them. if 'allocator' is NULL, this is the same as json_new() */
+EXPORT json_err json_newWithAllocator(struct json **json, struct json_element **root, const struct json_allocator *allocator);
 EXPORT json_err json_destroy    (struct json *json);
+
+/* empty the document, and get it ready to parse another one, as if it had just come from
+   json_new() - but the memory that it has built up (the parse buffer, and the arena that
+   the elements live in) is kept and used again, rather than being given back. anything
+   from json_set...() is kept too. as with json_destroy(), the root and every element in it
+   are gone, and json_dataBorrow() / json_parseFile() data is let go of */
+EXPORT json_err json_reset      (struct json *json);
 EXPORT json_err json_getRoot    (struct json *json, struct json_element **root);
 EXPORT json_err json_isComplete (struct json *json);
+EXPORT json_err json_setDuplicatePolicy(struct json *json, enum json_duplicatePolicy policy);
 EXPORT json_err json_dataAdd    (struct json *json, const unsigned char *data, unsigned int len);
 
+/* when one of the document's buffers (e.g: the one that json_dataAdd() copies into, or the
+   one that json_print() writes to) runs out of space, it grows by 'percent' of its size, or
+   by as much as is needed if that's more. the default (or 0) is 100, doubling it each time.
+   buffers are never shrunk while the document is in use, so they can be reused */
+EXPORT json_err json_setBufferGrowth(struct json *json, unsigned int percent);
+
+/* once an object has 'width' or more members, the first search through them by name (e.g:
+   json_getElement(), or the duplicate check when adding to it) builds a hash index, which
+   is kept up to date from then on. the members stay in order. the default (or 0) is 32 */
+EXPORT json_err json_setIndexWidth(struct json *json, unsigned int width);
+
+/* only parse the top level of the document up front. nested objects and arrays are stepped
+   over, and their contents are parsed the first time that something looks inside them (e.g:
+   json_getElement(), json_getChildren() or json_print()), which may then fail with an error
+   from the parser. the data given to json_dataAdd() is kept until json_destroy().
+   this must be called before any data is added */
+EXPORT json_err json_setLazy    (struct json *json, int lazy);
+
+/* only build the elements that are on one of 'paths' (a NULL terminated list, in the same form
+   as the identifiers given to json_getElement(), e.g: "user.id" or "items[0].price"), along with
+   their parents. everything under the end of a path is kept. anything else is checked and then
+   thrown away as it is parsed. this must be called before any data is added */
+EXPORT json_err json_setProjection(struct json *json, unsigned char **paths);
+
+/* hand everything that json_dataAdd() finds to 'callbacks' as it goes, instead of building
+   elements - the root will stay empty. this must be called before any data is added */
+EXPORT json_err json_setCallbacks(struct json *json, const struct json_callbacks *callbacks, void *ctx);
+
+/* accept any number of documents one after another (e.g: newline delimited JSON), rather than
+   stopping at the end of the first. as each root object closes, it is given to onDocument(),
+   and is then emptied ready for the next one - so the root and everything in it is only valid
+   until onDocument() returns. json_dataAdd() will return JSON_EINCOMPLETE between documents.
+   returning anything other than JSON_ENONE from onDocument() stops the parse with that error.
+   this must be called before any data is added */
+EXPORT json_err json_setDocumentCallback(struct json *json, json_err (*onDocument)(void *ctx, struct json_element *root), void *ctx);
+
+/* parse a complete document in place, without copying it. names and string values point
+   straight into 'data', terminated by writing a '\0' over their closing delimiter (and any
+   escapes are decoded where they are), so 'data' must be writable. json_destroy() and
+   json_deleteElement() will never free() these.
+     json_dataBorrow() - the caller keeps ownership, and 'data' must outlive the document
+     json_dataAdopt()  - the document takes ownership, and json_destroy() will free() 'data'
+                         (or give it back to the document's allocator)
+   like json_dataAdd(), these return JSON_ECOMPLETE on success. json_dataAdd() can't be used
+   on the same document afterwards */
+EXPORT json_err json_dataBorrow  (struct json *json, unsigned char *data, unsigned int len);
+EXPORT json_err json_dataAdopt   (struct json *json, unsigned char *data, unsigned int len);
+
+/* mmap() the file at 'path' and parse it in place, like json_dataBorrow() - there is no read()
+   loop, and nothing is copied. the mapping is private, so the file is never written to, and it
+   is kept until json_destroy(). returns JSON_ECOMPLETE on success, or JSON_EMISSING if the file
+   can't be opened (see errno) */
+EXPORT json_err json_parseFile   (struct json *json, const char *path);
+
+/* parse a complete document that is one big array (e.g: "[{...},{...},...]") using 'threads'
+   threads, or one per CPU if 'threads' is 0. the root will be a JSON_ARRAY. anything else, or
+   anything small, is parsed as normal - as is everything after json_setLazy() or
+   json_setProjection(). returns JSON_ECOMPLETE on success */
+EXPORT json_err json_dataParallel(struct json *json, const unsigned char *data, unsigned int len, unsigned int threads);
+
 EXPORT json_err json_addNull    (struct json_element *root, unsigned char *parent, unsigned char *name);
 EXPORT json_err json_addBoolean (struct json_element *root, unsigned char *parent, unsigned char *name, int data);
 EXPORT json_err json_addInteger (struct json_element *root, unsigned char *parent, unsigned char *name, int data);
+EXPORT json_err json_addInteger64 (struct json_element *root, unsigned char *parent, unsigned char *name, int64_t data);
+EXPORT json_err json_addUInteger64(struct json_element *root, unsigned char *parent, unsigned char *name, uint64_t data);
 EXPORT json_err json_addFloat   (struct json_element *root, unsigned char *parent, unsigned char *name, double data);
 EXPORT json_err json_addString  (struct json_element *root, unsigned char *parent, unsigned char *name, unsigned char *data, unsigned int dataLen);
 EXPORT json_err json_addFunction(struct json_element *root, unsigned char *parent, unsigned char *name, unsigned char *data, unsigned int dataLen);
@@ -86,6 +213,8 @@ EXPORT json_err json_dataSet    (struct json_element *root, unsigned char *ident
 
 EXPORT json_err json_getBoolean (struct json_element *root, unsigned char *identifier, int *data);
 EXPORT json_err json_getInteger (struct json_element *root, unsigned char *identifier, int *data);
+EXPORT json_err json_getInteger64 (struct json_element *root, unsigned char *identifier, int64_t *data);
+EXPORT json_err json_getUInteger64(struct json_element *root, unsigned char *identifier, uint64_t *data);
 EXPORT json_err json_getFloat   (struct json_element *root, unsigned char *identifier, double *data);
 EXPORT json_err json_getString  (struct json_element *root, unsigned char *identifier, unsigned char **data, unsigned int *dataLen);
 EXPORT json_err json_getFunction(struct json_element *root, unsigned char *identifier, unsigned char **data, unsigned int *dataLen);
@@ -95,6 +224,133 @@ EXPORT json_err json_getObject  (struct json_element *root, unsigned char *ident
 
 EXPORT json_err json_deleteElement(struct json_element *root, unsigned char *identifier);
 
+/* work on an element that you already have (e.g: from json_getObject(), or from the calls
+   below) directly, without an identifier being read. nothing is allocated, other than the new
+   element in json_elementAddChild(), and the children of a lazy element, which are parsed the
+   first time that they are looked at (see json_setLazy()). the json_get...() calls above are
+   the same as finding the element, and then calling these */
+EXPORT json_err json_elementGetType      (struct json_element *element, enum json_dataTypes *type);
+/* JSON_EMISSING for array members and the root, which don't have a name. not terminated */
+EXPORT json_err json_elementGetName      (struct json_element *element, unsigned char **name, unsigned int *nameLen);
+EXPORT json_err json_elementGetBoolean   (struct json_element *element, int *data);
+EXPORT json_err json_elementGetInteger   (struct json_element *element, int *data);
+EXPORT json_err json_elementGetInteger64 (struct json_element *element, int64_t *data);
+EXPORT json_err json_elementGetUInteger64(struct json_element *element, uint64_t *data);
+EXPORT json_err json_elementGetFloat     (struct json_element *element, double *data);
+EXPORT json_err json_elementGetString    (struct json_element *element, unsigned char **data, unsigned int *dataLen);
+/* the number of members of an object, or of an array */
+EXPORT json_err json_elementGetChildCount(struct json_element *element, unsigned int *count);
+
+/* these return JSON_EMISSING if there isn't one (e.g: at the end of the children) */
+EXPORT json_err json_elementGetParent    (struct json_element *element, struct json_element **parent);
+EXPORT json_err json_elementGetFirstChild(struct json_element *element, struct json_element **child);
+EXPORT json_err json_elementGetNext      (struct json_element *element, struct json_element **sibling);
+
+/* add a JSON_NULL to the end of an object ('name' is needed, and is copied) or of an array
+   ('name' must be NULL). give it a value with one of the json_elementSet...() calls */
+EXPORT json_err json_elementAddChild     (struct json_element *parent, const unsigned char *name, unsigned int nameLen, struct json_element **child);
+/* give the element a new value, throwing away the old one (and everything that was under
+   it). it keeps its name and its place. the root can only be made an empty object or array.
+   an old string's memory isn't given back until json_reset() (see json_new()) */
+EXPORT json_err json_elementSetNull      (struct json_element *element);
+EXPORT json_err json_elementSetBoolean   (struct json_element *element, int data);
+EXPORT json_err json_elementSetInteger64 (struct json_element *element, int64_t data);
+EXPORT json_err json_elementSetUInteger64(struct json_element *element, uint64_t data);
+EXPORT json_err json_elementSetFloat     (struct json_element *element, double data);
+EXPORT json_err json_elementSetString    (struct json_element *element, const unsigned char *data, unsigned int dataLen);
+EXPORT json_err json_elementSetObject    (struct json_element *element);
+EXPORT json_err json_elementSetArray     (struct json_element *element);
+/* take the element out of its parent, and destroy it along with everything under it.
+   the element can't be used afterwards, and the root can't be removed */
+EXPORT json_err json_elementRemove       (struct json_element *element);
+
+/* go through the children of an object or an array, in order, without allocating anything:
+     struct json_iterator it;
+     json_iteratorInit(&it, parent);
+     while (json_iteratorNext(&it, &child, &name, &nameLen) == JSON_ENONE) { ... }
+   'name' is NULL (and 'nameLen' 0) for array members, and isn't terminated. any of 'child',
+   'name' and 'nameLen' may be NULL. json_iteratorNext() returns JSON_EMISSING at the end, and
+   json_iteratorDone() is true once there are no children left. the child that was just given
+   out may be removed, but no other children of 'parent' may be until the iterator is done */
+struct json_iterator {
+	struct json_element *next;
+};
+EXPORT json_err json_iteratorInit(struct json_iterator *iterator, struct json_element *parent);
+EXPORT json_err json_iteratorNext(struct json_iterator *iterator, struct json_element **child, unsigned char **name, unsigned int *nameLen);
+EXPORT int      json_iteratorDone(struct json_iterator *iterator);
+
+/* read 'identifier' (in the same form as above, e.g: "items[0].price") once, so that it can be
+   used over and over without being read again each time. a path isn't tied to a document, so
+   the same one can be used with any of them. it comes from malloc(), and is given back by
+   json_pathFree(). each of the calls below is the same as the one without 'Path' on the end,
+   but takes a path in place of the identifier (or of the parent, for json_add...()) */
+EXPORT json_err json_pathCompile(const unsigned char *identifier, struct json_path **path);
+EXPORT json_err json_pathFree   (struct json_path *path);
+
+EXPORT json_err json_addNullPath    (struct json_element *root, struct json_path *path, unsigned char *name);
+EXPORT json_err json_addBooleanPath (struct json_element *root, struct json_path *path, unsigned char *name, int data);
+EXPORT json_err json_addIntegerPath (struct json_element *root, struct json_path *path, unsigned char *name, int data);
+EXPORT json_err json_addInteger64Path (struct json_element *root, struct json_path *path, unsigned char *name, int64_t data);
+EXPORT json_err json_addUInteger64Path(struct json_element *root, struct json_path *path, unsigned char *name, uint64_t data);
+EXPORT json_err json_addFloatPath   (struct json_element *root, struct json_path *path, unsigned char *name, double data);
+EXPORT json_err json_addStringPath  (struct json_element *root, struct json_path *path, unsigned char *name, unsigned char *data, unsigned int dataLen);
+EXPORT json_err json_addObjectPath  (struct json_element *root, struct json_path *path, unsigned char *name, struct json_element **element);
+EXPORT json_err json_addArrayPath   (struct json_element *root, struct json_path *path, unsigned char *name, struct json_element **element);
+
+EXPORT json_err json_getTypePath    (struct json_element *root, struct json_path *path, enum json_dataTypes *type);
+EXPORT json_err json_getChildrenPath(struct json_element *root, struct json_path *path, unsigned char ***children);
+
+EXPORT json_err json_dataGetPath    (struct json_element *root, struct json_path *path, void **user_data);
+EXPORT json_err json_dataSetPath    (struct json_element *root, struct json_path *path, void *user_data);
+
+EXPORT json_err json_getBooleanPath (struct json_element *root, struct json_path *path, int *data);
+EXPORT json_err json_getIntegerPath (struct json_element *root, struct json_path *path, int *data);
+EXPORT json_err json_getInteger64Path (struct json_element *root, struct json_path *path, int64_t *data);
+EXPORT json_err json_getUInteger64Path(struct json_element *root, struct json_path *path, uint64_t *data);
+EXPORT json_err json_getFloatPath   (struct json_element *root, struct json_path *path, double *data);
+EXPORT json_err json_getStringPath  (struct json_element *root, struct json_path *path, unsigned char **data, unsigned int *dataLen);
+EXPORT json_err json_getArrayLenPath(struct json_element *root, struct json_path *path, unsigned int *length);
+EXPORT json_err json_getArrayPath   (struct json_element *root, struct json_path *path, struct json_element **target);
+EXPORT json_err json_getObjectPath  (struct json_element *root, struct json_path *path, struct json_element **target);
+
+EXPORT json_err json_deleteElementPath(struct json_element *root, struct json_path *path);
+
+/* look up a whole set of paths in one go. the paths are put together into a tree, so that
+   the parts that they have in common (e.g: "request.header.") are only looked through once,
+   however many of them there are. json_batchCompile() takes a NULL terminated list of
+   identifiers, and json_batchCompilePaths() takes a NULL terminated list from
+   json_pathCompile(), which must be kept until json_batchFree(). like a path, a batch
+   isn't tied to a document, and can be used over and over with any of them */
+struct json_batchResult {
+	struct json_element *element; /* NULL if the path isn't there */
+	enum json_dataTypes type;     /* JSON_MISSING if the path isn't there */
+};
+EXPORT json_err json_batchCompile     (unsigned char **paths, struct json_batch **batch);
+EXPORT json_err json_batchCompilePaths(struct json_path **paths, struct json_batch **batch);
+EXPORT json_err json_batchFree        (struct json_batch *batch);
+/* fill in 'results', which has one entry for each of the paths, in the same order. a path
+   that isn't there is not an error, it is just left as JSON_MISSING */
+EXPORT json_err json_batchGet         (struct json_element *root, struct json_batch *batch, struct json_batchResult *results);
+
+/* find every element that matches a query, a lot like JSONPath:
+     "$.items[*].price"              - '$' is the root given to json_queryRun(), and may be left off
+     "items[0]" / "['a name']"       - an array index, or a name that has odd characters in it
+     "store..id"                     - 'id', at any depth under 'store'
+     "$..*"                          - everything
+     "items[?(@.status == \"ok\")]"  - the members of 'items' that pass a test. the left hand side
+                                       is a path from '@', the member. the right hand side is a
+                                       string, a number, true, false or null. the comparison is
+                                       one of == != < <= > >=, or it can be left off, and then the
+                                       path just has to be there
+   a query is compiled once by json_queryCompile(), and isn't tied to a document, so it can be
+   run over and over against any of them. it comes from malloc(), and is given back by
+   json_queryFree(). json_queryRun() gives each match to onMatch() as soon as it is found -
+   nothing is collected up. the tree mustn't be changed until json_queryRun() returns.
+   returning anything other than JSON_ENONE from onMatch() stops the query with that error */
+EXPORT json_err json_queryCompile(const unsigned char *query, struct json_query **compiled);
+EXPORT json_err json_queryFree   (struct json_query *query);
+EXPORT json_err json_queryRun    (struct json_element *root, struct json_query *query, json_err (*onMatch)(void *ctx, struct json_element *element), void *ctx);
+
 EXPORT json_err json_print      (struct json *json, unsigned char **output, unsigned int *outputLen);
 EXPORT json_err json_printElement(struct json_element *root, unsigned char **output, unsigned int *outputLen);
 
@@ -24,12 +24,17 @@
 #define LH() fprintf(stderr, "%s:%d %s()\n", __FILE__, __LINE__, __FUNCTION__)
 
 #include "json.h"
+#include "alloc.h"
 #include "buf.h"
+#include "scan.h"
+#include "arena.h"
+#include "map.h"
 
 struct json;
 struct json_parse;
 struct json_parseState;
 struct json_element;
+struct json_projection;
 
 enum identifierType {
 	ID_INVALID,
@@ -37,6 +42,30 @@ enum identifierType {
 	ID_IDENTIFIER,
 };
 
+enum parseFlags {
+	PARSE_BORROW = 0x01, /* names and strings point into the buffer, instead of being copied */
+	PARSE_ADOPT  = 0x02, /* the buffer was handed to us, and must be free()'d by json_destroy() */
+	PARSE_CALLBACKS = 0x04, /* don't build elements, call the user's callbacks instead */
+	PARSE_STREAM = 0x08, /* there may be more than one document */
+	PARSE_ARRAYROOT = 0x10, /* the document may be an array, rather than an object */
+	PARSE_MAPPED = 0x20, /* the buffer is a file mmap()'d by json_parseFile() */
+	PARSE_LAZY = 0x40, /* skip over nested objects / arrays, and only parse them when asked */
+};
+
+enum elementFlags {
+	ELEMENT_UNSIGNED = 0x02, /* the integer is above INT64_MAX, and is held in data.asUInt64 */
+	ELEMENT_LAZY     = 0x04, /* the children haven't been parsed yet - they are data_len bytes of
+	                            the parse buffer, starting at offset data.asUInt64 */
+	ELEMENT_INLINE   = 0x08, /* the string is short enough to live in data.asInline */
+	ELEMENT_USERDATA = 0x10, /* there is an entry for this element in the document's userData */
+	ELEMENT_INTERNED = 0x20, /* the name is shared with every other element of the same name,
+	                            and has a struct json_internName in front of it */
+	ELEMENT_INDEXED  = 0x40, /* there is a struct json_index (object) or struct json_vector
+	                            (array) of the children in json->indexes */
+	ELEMENT_FAILED   = 0x80, /* a lazy element whose children couldn't be parsed - data.asInt
+	                            holds the error */
+};
+
 enum characterType {
 	CHAR_NONE,
 	CHAR_SPACE,
@@ -55,19 +84,36 @@ struct json_parseState {
 	unsigned int q_value; /* quoted? 2 = yes, 1 = no, 0 = unknown */
 };
 
+/* an object / array that is being stepped over without being parsed */
+struct json_parseSkip {
+	unsigned int depth; /* 0 = not skipping */
+	unsigned int quoted;
+	unsigned int start;
+	struct json_element *element; /* if not NULL, this is given the span once we're done */
+};
+
 struct json_parse {
 	json_err err;
+	unsigned int flags;
+	enum json_duplicatePolicy duplicates;
 	struct json_buf buf;
+	struct json_scan scan;
 	unsigned int pos;
 	struct json_element *element;
+	struct json_buf stack; /* the type of each container that we are inside of, one byte each */
 	struct json_parseState state;
+	struct json_parseSkip skip;
+	struct json_projection *projection; /* only keep what is on these paths */
+	struct json_buf levels; /* a struct json_projectionLevel for each open object / array */
+	struct json_callbacks callbacks;
+	void *ctx;
+	json_err (*onDocument)(void *ctx, struct json_element *root);
+	void *documentCtx;
 };
 
-struct json {
-	struct json_parse parse;
-	struct json_element *root;
-};
-
+/* this is kept small, as there's one for every value in the document (72 bytes on a
+   64-bit machine). the first child's sibling_prev points at the last child, so that
+   appending doesn't need a child_tail */
 struct json_element {
 	struct json *json;
 	struct json_element *parent;
@@ -75,17 +121,36 @@ struct json_element {
 	struct json_element *sibling_next;
 	struct json_element *child_head;
 
-	void *user_data;
-
 	unsigned char *name;
 
-	enum json_dataTypes type;
-	unsigned int data_len;
 	union {
 		unsigned char *asRaw;
+		unsigned char asInline[8]; /* a string of up to 7 bytes, and its '\0' */
 		int asInt;
+		int64_t asInt64;
+		uint64_t asUInt64;
 		double asFloat;
 	} data;
+
+	unsigned int name_len;
+	unsigned int data_len;
+	unsigned char type; /* enum json_dataTypes */
+	unsigned char flags;
+	unsigned int child_count;
+};
+
+struct json {
+	struct json_allocator allocator;
+	struct json_parse parse;
+	struct json_arena arena; /* where all of the elements, names and strings live */
+	struct json_map userData; /* json_dataSet()'s pointers, as hardly any elements have one */
+	struct json_map indexes; /* for each ELEMENT_INDEXED object / array */
+	unsigned int indexWidth; /* objects / arrays this wide get one (0 = JSON_INDEX_WIDTH) */
+	unsigned char **intern; /* the names, each stored once - open addressing, internLen slots */
+	unsigned int internLen;
+	unsigned int internCount;
+	struct json_element *root;
+	struct json_element rootElement;
 };
 
 #endif /* __JSON_INT_H */
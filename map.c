@@ -0,0 +1,111 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_int.h"
+#include "map.h"
+
+/* where 'element' would be, if nothing else was in the way */
+static unsigned int json_mapHome(struct json_map *map, struct json_element *element) {
+	/* elements are at least 8 byte aligned, so the bottom bits are always the same */
+	return (unsigned int)(((uintptr_t)element >> 3) * 2654435761u) & (map->len - 1);
+}
+
+/* where 'element' is, or should go, in the map */
+static unsigned int json_mapSlot(struct json_map *map, struct json_element *element) {
+	unsigned int i;
+
+	for (i = json_mapHome(map, element); map->entries[i].element && map->entries[i].element != element; i = (i + 1) & (map->len - 1));
+
+	return i;
+}
+
+json_err json_mapSet(const struct json_allocator *allocator, struct json_map *map, struct json_element *element, void *data) {
+	struct json_mapEntry *old, *new;
+	unsigned int i, oldLen, newLen;
+
+	/* keep it no more than half full */
+	if ((map->count + 1) * 2 > map->len) {
+		newLen = map->len ? map->len * 2 : 16;
+		if ((new = json_alloc(allocator, sizeof(*new) * newLen)) == NULL) return JSON_ENOMEM;
+		memset(new, 0, sizeof(*new) * newLen);
+		old = map->entries;
+		oldLen = map->len;
+		map->entries = new;
+		map->len = newLen;
+		for (i = 0; i < oldLen; i++) {
+			if (old[i].element) map->entries[json_mapSlot(map, old[i].element)] = old[i];
+		}
+		json_free(allocator, old);
+	}
+
+	i = json_mapSlot(map, element);
+	if (!map->entries[i].element) map->count++;
+	map->entries[i].element = element;
+	map->entries[i].data = data;
+
+	return JSON_ENONE;
+}
+
+void *json_mapGet(struct json_map *map, struct json_element *element) {
+	if (!map->count) return NULL;
+	return map->entries[json_mapSlot(map, element)].data;
+}
+
+void json_mapRemove(struct json_map *map, struct json_element *element) {
+	struct json_mapEntry *u;
+	unsigned int i, j, k;
+
+	if (!map->count) return;
+	u = map->entries;
+
+	i = json_mapSlot(map, element);
+	if (!u[i].element) return;
+	u[i].element = NULL;
+	u[i].data = NULL;
+	map->count--;
+
+	/* close the gap - pull back anything after it that would no longer be found */
+	for (j = (i + 1) & (map->len - 1); u[j].element; j = (j + 1) & (map->len - 1)) {
+		k = json_mapHome(map, u[j].element);
+		/* is its home slot cyclically in (i, j]? then it can stay */
+		if ((i < j) ? (i < k && k <= j) : (i < k || k <= j)) continue;
+		u[i] = u[j];
+		u[j].element = NULL;
+		u[j].data = NULL;
+		i = j;
+	}
+}
+
+/* forget everything, but keep the space */
+void json_mapClear(struct json_map *map) {
+	if (!map->count) return;
+	memset(map->entries, 0, sizeof(*map->entries) * map->len);
+	map->count = 0;
+}
+
+void json_mapFree(const struct json_allocator *allocator, struct json_map *map) {
+	json_free(allocator, map->entries);
+	map->entries = NULL;
+	map->len = 0;
+	map->count = 0;
+}
@@ -0,0 +1,43 @@
+#ifndef __MAP_H
+#define __MAP_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* a pointer for each of a few elements, kept to one side rather than in every element
+   (e.g: json_dataSet()'s user data). open addressing, keyed on the element's address */
+struct json_mapEntry {
+	struct json_element *element;
+	void *data;
+};
+
+struct json_map {
+	struct json_mapEntry *entries; /* 'len' of them, a power of 2 */
+	unsigned int len;
+	unsigned int count;
+};
+
+json_err json_mapSet(const struct json_allocator *allocator, struct json_map *map, struct json_element *element, void *data);
+void *json_mapGet(struct json_map *map, struct json_element *element);
+void json_mapRemove(struct json_map *map, struct json_element *element);
+void json_mapClear(struct json_map *map);
+void json_mapFree(const struct json_allocator *allocator, struct json_map *map);
+
+#endif /* __MAP_H */
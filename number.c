@@ -0,0 +1,227 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <locale.h>
+
+#include "json_int.h"
+#include "number.h"
+
+/* every power of ten up to 10^22 is exactly representable as a double */
+static const double exactPow10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static json_err json_numberParseHex(const unsigned char *str, unsigned int len, int negative, struct json_number *number) {
+	uint64_t v;
+	unsigned int i;
+	unsigned char c;
+
+	if (len == 0 || len > 16) return JSON_EINVAL;
+
+	for (i = 0, v = 0; i < len; i++) {
+		c = str[i];
+		if      (c >= '0' && c <= '9') c -= '0';
+		else if (c >= 'a' && c <= 'f') c -= 'a' - 10;
+		else if (c >= 'A' && c <= 'F') c -= 'A' - 10;
+		else return JSON_EINVAL;
+		v = (v << 4) | c;
+	}
+
+	number->type = JSON_INTEGER;
+	number->isUnsigned = 0;
+	if (negative) {
+		if (v > (uint64_t)INT64_MAX + 1) return JSON_EINVAL;
+		number->data.asInt64 = (int64_t)(0 - v);
+	} else if (v > INT64_MAX) {
+		number->isUnsigned = 1;
+		number->data.asUInt64 = v;
+	} else {
+		number->data.asInt64 = v;
+	}
+
+	return JSON_ENONE;
+}
+
+/* the slow path - let strtod() get it exactly right, but in the "C" locale, so that
+   a ',' decimal point in the application's locale doesn't break us */
+static json_err json_numberParseSlow(const unsigned char *str, unsigned int len, double *value) {
+	static locale_t cLocale = (locale_t)0;
+	locale_t l, old;
+	char tmp[64];
+	char *s, *end;
+	double v;
+
+	if (!cLocale) {
+		if ((l = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0)) == (locale_t)0) return JSON_ENOMEM;
+		if (!__sync_bool_compare_and_swap(&cLocale, (locale_t)0, l)) freelocale(l);
+	}
+
+	/* strtod() needs a terminated string */
+	if (len < sizeof(tmp)) {
+		s = tmp;
+	} else if ((s = malloc(len + 1)) == NULL) {
+		return JSON_ENOMEM;
+	}
+	memcpy(s, str, len);
+	s[len] = '\0';
+
+	old = uselocale(cLocale);
+	v = strtod(s, &end);
+	uselocale(old);
+
+	if (s != tmp) free(s);
+	if (end != &(s[len])) return JSON_EINVAL;
+	/* too big for a double - infinity can't be printed as JSON, so it can't be kept */
+	if (isinf(v)) return JSON_ERANGE;
+
+	*value = v;
+
+	return JSON_ENONE;
+}
+
+json_err json_numberParse(const unsigned char *str, unsigned int len, struct json_number *number) {
+	const unsigned char *t, *end;
+	int negative, expNegative;
+	uint64_t mantissa;
+	unsigned int digits, intDigits, fracDigits, expDigits, dropped;
+	int exp, exp10;
+
+	if (!str || !number) return JSON_EMISSINGPARAM;
+
+	t = str;
+	end = &(str[len]);
+
+	/* allow a sign */
+	negative = 0;
+	if (t < end && (*t == '-' || *t == '+')) {
+		negative = (*t == '-');
+		t++;
+	}
+
+	/* hex is always an integer */
+	if (end - t > 2 && t[0] == '0' && (t[1] == 'x' || t[1] == 'X')) {
+		return json_numberParseHex(&(t[2]), end - t - 2, negative, number);
+	}
+
+	/* integer part - keep up to 19 significant digits, which can't overflow */
+	mantissa = 0;
+	digits = 0;
+	dropped = 0;
+	for (intDigits = 0; t < end && *t >= '0' && *t <= '9'; t++, intDigits++) {
+		if (digits < 19) {
+			mantissa = (mantissa * 10) + (*t - '0');
+			if (mantissa) digits++;
+		} else {
+			dropped++;
+		}
+	}
+
+	/* the 20th digit might still fit in a uint64_t */
+	if (t == end && intDigits && dropped == 1) {
+		unsigned int d = end[-1] - '0';
+		if (mantissa < UINT64_MAX / 10 || (mantissa == UINT64_MAX / 10 && d <= UINT64_MAX % 10)) {
+			mantissa = (mantissa * 10) + d;
+			dropped = 0;
+		}
+	}
+
+	/* plain integer! */
+	if (t == end) {
+		if (intDigits == 0) return JSON_EINVAL;
+		if (dropped == 0) {
+			number->type = JSON_INTEGER;
+			number->isUnsigned = 0;
+			if (negative) {
+				if (mantissa <= (uint64_t)INT64_MAX + 1) {
+					number->data.asInt64 = (int64_t)(0 - mantissa);
+					return JSON_ENONE;
+				}
+			} else if (mantissa > INT64_MAX) {
+				number->isUnsigned = 1;
+				number->data.asUInt64 = mantissa;
+				return JSON_ENONE;
+			} else {
+				number->data.asInt64 = mantissa;
+				return JSON_ENONE;
+			}
+		}
+		/* too big for 64-bits... fall through to a float */
+	}
+
+	/* fractional part */
+	fracDigits = 0;
+	if (t < end && *t == '.') {
+		for (t++; t < end && *t >= '0' && *t <= '9'; t++, fracDigits++) {
+			if (digits < 19) {
+				mantissa = (mantissa * 10) + (*t - '0');
+				if (mantissa) digits++;
+			} else {
+				dropped++;
+			}
+		}
+	}
+	if (intDigits + fracDigits == 0) return JSON_EINVAL;
+
+	/* exponent */
+	exp = 0;
+	if (t < end && (*t == 'e' || *t == 'E')) {
+		t++;
+		expNegative = 0;
+		if (t < end && (*t == '-' || *t == '+')) {
+			expNegative = (*t == '-');
+			t++;
+		}
+		for (expDigits = 0; t < end && *t >= '0' && *t <= '9'; t++, expDigits++) {
+			if (exp < 100000) exp = (exp * 10) + (*t - '0');
+		}
+		if (expDigits == 0) return JSON_EINVAL;
+		if (expNegative) exp = -exp;
+	}
+	if (t != end) return JSON_EINVAL;
+
+	number->type = JSON_FLOAT;
+	number->isUnsigned = 0;
+
+#if FLT_EVAL_METHOD == 0
+	/* the fast path - if both the mantissa and the power of ten are exact doubles,
+	   then a single multiply / divide is correctly rounded */
+	exp10 = exp - (int)fracDigits;
+	if (dropped == 0 && mantissa <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+		double v = (double)mantissa;
+		if (exp10 < 0) {
+			v /= exactPow10[-exp10];
+		} else {
+			v *= exactPow10[exp10];
+		}
+		number->data.asFloat = negative ? -v : v;
+		return JSON_ENONE;
+	}
+#else
+	(void)exp10;
+#endif
+
+	return json_numberParseSlow(str, len, &number->data.asFloat);
+}
@@ -0,0 +1,39 @@
+#ifndef __NUMBER_H
+#define __NUMBER_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+
+struct json_number {
+	enum json_dataTypes type; /* JSON_INTEGER or JSON_FLOAT */
+	int isUnsigned;           /* the integer is above INT64_MAX, so look at asUInt64 */
+	union {
+		int64_t asInt64;
+		uint64_t asUInt64;
+		double asFloat;
+	} data;
+};
+
+/* scan the 'len' bytes at 'str' as a number. returns JSON_EINVAL if it isn't one.
+   integers that don't fit in 64-bits are returned as floats */
+json_err json_numberParse(const unsigned char *str, unsigned int len, struct json_number *number);
+
+#endif /* __NUMBER_H */
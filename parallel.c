@@ -0,0 +1,258 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "json_int.h"
+#include "parse.h"
+#include "parallel.h"
+#include "element.h"
+#include "index.h"
+
+/* don't bother splitting the input into pieces smaller than this */
+#define JSON_PARALLEL_MIN_CHUNK (64 * 1024)
+#define JSON_PARALLEL_MAX_THREADS 256
+
+struct json_parallelChunk {
+	struct json *target;
+	const unsigned char *data;
+	unsigned int len;
+	struct json *json;
+	json_err ret;
+	int started;
+	pthread_t thread;
+};
+
+/* is 'c' at 'i' likely to be a ',' between two elements of the top-level array?
+   we can't know for sure without having parsed everything before it, so just look
+   for a '}' / ']' before it and a '{' / '[' after it, which is how records look */
+static int json_parallelLikely(const unsigned char *data, unsigned int len, unsigned int i) {
+	unsigned int j;
+
+	for (j = i; j > 0 && isspace(data[j - 1]); j--);
+	if (j == 0 || (data[j - 1] != '}' && data[j - 1] != ']')) return 0;
+
+	for (j = i + 1; j < len && isspace(data[j]); j++);
+	if (j == len || (data[j] != '{' && data[j] != '[')) return 0;
+
+	return 1;
+}
+
+/* find a ',' to split at, somewhere in [from, to). returns 'to' if there isn't one */
+static unsigned int json_parallelSplit(const unsigned char *data, unsigned int from, unsigned int to) {
+	const unsigned char *c;
+	unsigned int i, any;
+
+	any = to;
+	for (i = from; i < to; i = c - data + 1) {
+		if ((c = memchr(&(data[i]), ',', to - i)) == NULL) break;
+		if (json_parallelLikely(data, to, c - data)) return c - data;
+		if (any == to) any = c - data;
+	}
+
+	/* no records... maybe it's an array of scalars */
+	return any;
+}
+
+/* give every element under 'root' to 'json' */
+static void json_parallelAdopt(struct json *json, struct json_element *root) {
+	struct json_element *e;
+
+	for (e = root->child_head; e;) {
+		/* any indexes belong to the piece, so they go - they'll be built again if needed */
+		if (e->flags & ELEMENT_INDEXED) json_indexFree(e);
+		e->json = json;
+		if (e->child_head) {
+			e = e->child_head;
+			continue;
+		}
+		while (e != root && !e->sibling_next) e = e->parent;
+		if (e == root) break;
+		e = e->sibling_next;
+	}
+}
+
+/* parse one run of elements from the array, as if it were an array of its own.
+   if the split was in the wrong place, this will fail (or finish too early) */
+static json_err json_parallelParse(struct json_parallelChunk *c) {
+	json_err ret;
+	struct json *json;
+	struct json_element *e;
+
+	/* the elements are going to end up in the target's arena, so they come from its allocator */
+	if ((ret = json_newWithAllocator(&json, NULL, &c->target->allocator)) != JSON_ENONE) return ret;
+	c->json = json;
+	json->parse.flags |= PARSE_ARRAYROOT;
+	json->parse.duplicates = c->target->parse.duplicates;
+	json->parse.buf.growth = c->target->parse.buf.growth;
+	json->parse.stack.growth = c->target->parse.stack.growth;
+	json->parse.levels.growth = c->target->parse.levels.growth;
+	json->indexWidth = c->target->indexWidth;
+
+	ret = json_dataAdd(json, (unsigned char *)"[", 1);
+	if (ret == JSON_ENONE || ret == JSON_EINCOMPLETE) ret = json_dataAdd(json, c->data, c->len);
+	if (ret != JSON_ENONE && ret != JSON_EINCOMPLETE) return (ret == JSON_ECOMPLETE) ? JSON_EINVAL : ret;
+	if ((ret = json_dataAdd(json, (unsigned char *)"]", 1)) != JSON_ECOMPLETE) return (ret == JSON_ENONE) ? JSON_EINVAL : ret;
+	if (json->parse.pos != json->parse.buf.pos) return JSON_EINVAL;
+
+	/* the elements are going to be moved into the target */
+	json_parallelAdopt(c->target, json->root);
+	for (e = json->root->child_head; e; e = e->sibling_next) {
+		e->parent = c->target->root;
+	}
+
+	return JSON_ENONE;
+}
+
+static void *json_parallelWorker(void *arg) {
+	struct json_parallelChunk *c = arg;
+	c->ret = json_parallelParse(c);
+	return NULL;
+}
+
+json_err json_parallelRun(struct json *json, const unsigned char *data, unsigned int len, unsigned int threads) {
+	json_err ret;
+	struct json_parallelChunk *chunks;
+	struct json_element *root;
+	unsigned int s, e, i, n, at, split;
+
+	/* find the array's brackets */
+	for (s = 0; s < len && isspace(data[s]); s++);
+	for (e = len; e > s && isspace(data[e - 1]); e--);
+	if (e - s < 2 || data[s] != '[' || data[e - 1] != ']') return JSON_EINVAL;
+	s++;
+	e--;
+
+	if ((chunks = json_alloc(&json->allocator, sizeof(*chunks) * threads)) == NULL) return JSON_ENOMEM;
+	memset(chunks, 0, sizeof(*chunks) * threads);
+
+	/* speculatively split the contents into roughly equal runs of elements */
+	for (i = 0, n = 0, at = s; i < threads && at < e; i++, n++) {
+		chunks[n].target = json;
+		chunks[n].data = &(data[at]);
+		split = e;
+		if (i + 1 < threads) {
+			split = json_parallelSplit(data, s + (unsigned int)(((unsigned long long)(e - s) * (i + 1)) / threads), e);
+			if (split < at) split = json_parallelSplit(data, at, e);
+		}
+		chunks[n].len = split - at;
+		at = split + 1;
+	}
+
+	ret = JSON_ENONE;
+	for (i = 1; i < n; i++) {
+		if (pthread_create(&(chunks[i].thread), NULL, json_parallelWorker, &(chunks[i])) != 0) {
+			chunks[i].ret = JSON_EUNKNOWN;
+			continue;
+		}
+		chunks[i].started = 1;
+	}
+	if (n > 0) json_parallelWorker(&(chunks[0]));
+	for (i = 0; i < n; i++) {
+		if (chunks[i].started) pthread_join(chunks[i].thread, NULL);
+	}
+
+	/* validate the splits in order. the first piece starts in the right place, so if it
+	   parsed, it must also end in the right place - and so on. when a piece fails, the
+	   split at its end was wrong, so join it to the next piece and parse them again */
+	for (i = 0; i < n; i++) {
+		while (chunks[i].ret != JSON_ENONE && i + 1 < n) {
+			chunks[i].len = &(chunks[i + 1].data[chunks[i + 1].len]) - chunks[i].data;
+			json_destroy(chunks[i].json);
+			json_destroy(chunks[i + 1].json);
+			chunks[i].json = NULL;
+			memmove(&(chunks[i + 1]), &(chunks[i + 2]), sizeof(*chunks) * (n - i - 2));
+			n--;
+			json_parallelWorker(&(chunks[i]));
+		}
+		if (chunks[i].ret != JSON_ENONE) {
+			ret = chunks[i].ret;
+			break;
+		}
+	}
+
+	/* every piece was good - stitch them together */
+	root = json->root;
+	if (ret == JSON_ENONE) {
+		root->type = JSON_ARRAY;
+		for (i = 0; i < n; i++) {
+			struct json_element *r = chunks[i].json->root;
+			/* the elements live in the piece's arena, so that comes too */
+			json_arenaTake(&json->arena, &chunks[i].json->arena);
+			if (!r->child_head) continue;
+			if (!root->child_head) {
+				root->child_head = r->child_head;
+			} else {
+				struct json_element *tail = json_elementTail(root);
+				tail->sibling_next = r->child_head;
+				/* the head's sibling_prev is the tail, so swap them over */
+				root->child_head->sibling_prev = r->child_head->sibling_prev;
+				r->child_head->sibling_prev = tail;
+			}
+			root->child_count += r->child_count;
+			r->child_head = NULL;
+			r->child_count = 0;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		if (chunks[i].json) json_destroy(chunks[i].json);
+	}
+	json_free(&json->allocator, chunks);
+
+	return ret;
+}
+
+EXPORT json_err json_dataParallel(struct json *json, const unsigned char *data, unsigned int len, unsigned int threads) {
+	json_err ret;
+	long cpus;
+
+	if (!json || !data) return JSON_EMISSINGPARAM;
+	if (json->parse.buf.pos || json->parse.err != JSON_ENONE) return JSON_EINVAL;
+	if (json->parse.flags & (PARSE_CALLBACKS | PARSE_STREAM)) return JSON_EINVAL;
+
+	/* lazy elements point back into the parse buffer, which each piece has its own of, and the
+	   projection's array indexes are counted from the start of the whole array - so these
+	   are done the slow way, which gives the same document as with one thread */
+	if ((json->parse.flags & PARSE_LAZY) || json->parse.projection) threads = 1;
+
+	if (threads == 0) {
+		cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = (cpus > 0) ? cpus : 1;
+	}
+	if (threads > len / JSON_PARALLEL_MIN_CHUNK) threads = len / JSON_PARALLEL_MIN_CHUNK;
+	if (threads > JSON_PARALLEL_MAX_THREADS) threads = JSON_PARALLEL_MAX_THREADS;
+
+	json->parse.flags |= PARSE_ARRAYROOT;
+
+	if (threads > 1 && json_parallelRun(json, data, len, threads) == JSON_ENONE) {
+		return (json->parse.err = JSON_ECOMPLETE);
+	}
+
+	/* it's small, it isn't an array, or a split was wrong - do it the slow way, which
+	   will also find any genuine errors */
+	ret = json_dataAdd(json, data, len);
+	if (ret == JSON_ENONE || ret == JSON_EINCOMPLETE) ret = JSON_EINVAL;
+	return ret;
+}
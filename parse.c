@@ -21,186 +21,487 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "json_int.h"
 #include "parse.h"
+#include "scan.h"
+#include "add.h"
+#include "element.h"
+#include "number.h"
+#include "project.h"
+#include "unescape.h"
+#include "intern.h"
+#include "index.h"
+
+/* the type of the container that we are currently inside of */
+enum json_dataTypes json_parseContainer(struct json_parse *p) {
+	if (p->stack.pos == 0) return JSON_MISSING;
+	return p->stack.data[p->stack.pos - 1];
+}
+
+/* is the value that we are looking at on one of the projection's paths?
+   'node' is where it leads, to keep track of things inside it */
+int json_parseWanted(struct json_parse *p, unsigned char *name, unsigned int nameLen, struct json_projection **node) {
+	struct json_projectionLevel *level;
+
+	if (!p->projection) {
+		*node = NULL;
+		return 1;
+	}
+
+	/* the root is always wanted */
+	if (p->levels.pos == 0) {
+		*node = p->projection;
+		return 1;
+	}
+
+	level = &(((struct json_projectionLevel *)p->levels.data)[(p->levels.pos / sizeof(*level)) - 1]);
+	*node = json_projectionFind(level->node, name, nameLen, level->index);
+	level->index++;
+
+	return (*node != NULL);
+}
 
 json_err json_parseHandleElement(struct json *json, enum json_dataTypes type, unsigned char *name, unsigned int nameLen) {
 	json_err ret;
 	struct json_parse *p;
-	unsigned char c;
+	struct json_callbacks *cb;
+	struct json_element *element;
+	struct json_projectionLevel level;
+	unsigned char c = 0, t;
+	int borrow;
 	
 	if (!json) return JSON_EMISSINGPARAM;
 	if (type != JSON_OBJECT && type != JSON_ARRAY) return JSON_ETYPEMISMATCH;
 	p = &json->parse;
+	cb = &p->callbacks;
+	borrow = !!(p->flags & PARSE_BORROW);
+	
+	if (name && p->state.q_name == 2 && (ret = json_parseUnescape(name, &nameLen)) != JSON_ENONE) return ret;
+	
+	if (!json_parseWanted(p, name, nameLen, &level.node)) {
+		/* step over it, without making anything */
+		p->skip.depth = 1;
+		p->skip.quoted = 0;
+		p->skip.start = p->pos;
+		p->skip.element = NULL;
+		memset(&p->state, 0, sizeof(p->state));
+		p->pos++;
+		return JSON_ENONE;
+	}
 	
 	if (name) {
 		c = name[nameLen];
 		name[nameLen] = '\0';
 	}
 	
-	if (type == JSON_OBJECT) {
-		ret = json_addObject(p->element, "", name, &p->element);
-	} else {
-		ret = json_addArray(p->element, "", name, &p->element);
+	ret = JSON_ENONE;
+	if (p->flags & PARSE_CALLBACKS) {
+		if (name && cb->onKey) ret = cb->onKey(p->ctx, name, nameLen);
+		if (ret == JSON_ENONE) {
+			if (type == JSON_OBJECT && cb->onObjectStart) ret = cb->onObjectStart(p->ctx);
+			if (type == JSON_ARRAY && cb->onArrayStart) ret = cb->onArrayStart(p->ctx);
+		}
+	} else if (p->stack.pos == 0) {
+		/* this is the root */
+		json->root->type = type;
+		p->element = json->root;
+	} else if ((ret = json_elementAppend(p->element, name, nameLen, borrow, p->duplicates, &element)) == JSON_ENONE) {
+		element->type = type;
+		if ((p->flags & PARSE_LAZY) && !p->projection) {
+			/* don't go in... come back for it if it's wanted */
+			element->flags |= ELEMENT_LAZY;
+			p->skip.depth = 1;
+			p->skip.quoted = 0;
+			p->skip.start = p->pos;
+			p->skip.element = element;
+		} else {
+			p->element = element;
+		}
 	}
 	
-	if (name) {
+	/* when borrowing, the name lives on in the buffer - leave it terminated */
+	if (name && (ret != JSON_ENONE || !borrow || (p->flags & PARSE_CALLBACKS))) {
 		name[nameLen] = c;
 	}
 	
 	if (ret != JSON_ENONE) return ret;
 	
+	if (!p->skip.depth) {
+		t = type;
+		if ((ret = json_bufImport(&p->stack, &t, 1)) != JSON_ENONE) return ret;
+		if (p->projection) {
+			level.index = 0;
+			if ((ret = json_bufImport(&p->levels, (unsigned char *)&level, sizeof(level))) != JSON_ENONE) return ret;
+		}
+	}
+	
 	memset(&p->state, 0, sizeof(p->state));
 	p->pos++;
 	return JSON_ENONE;
 }
-				
+
+/* close the current container - the character at pos is either a '}' or a ']' */
+json_err json_parseHandleEnd(struct json *json) {
+	json_err ret;
+	struct json_parse *p;
+	struct json_callbacks *cb;
+	enum json_dataTypes type;
+
+	if (!json) return JSON_EMISSINGPARAM;
+	p = &json->parse;
+	cb = &p->callbacks;
+
+	type = json_parseContainer(p);
+	if (type != (p->buf.data[p->pos] == '}' ? JSON_OBJECT : JSON_ARRAY)) return JSON_EINVAL;
+
+	ret = JSON_ENONE;
+	if (p->flags & PARSE_CALLBACKS) {
+		if (type == JSON_OBJECT && cb->onObjectEnd) ret = cb->onObjectEnd(p->ctx);
+		if (type == JSON_ARRAY && cb->onArrayEnd) ret = cb->onArrayEnd(p->ctx);
+		if (ret != JSON_ENONE) return ret;
+	} else if (p->element->parent) {
+		p->element = p->element->parent;
+	}
+
+	p->stack.pos--;
+	if (p->projection) p->levels.pos -= sizeof(struct json_projectionLevel);
+	p->pos++;
+
+	/* was that the root? */
+	if (p->stack.pos == 0) return JSON_ECOMPLETE;
+
+	return JSON_ENONE;
+}
+
+/* hand a value to the user's callbacks, rather than building an element */
+json_err json_parseCallValue(struct json *json, unsigned char *name, unsigned int nameLen, enum json_dataTypes type, unsigned char *value, unsigned int valueLen, int boolean, struct json_number *number) {
+	json_err ret;
+	struct json_parse *p;
+	struct json_callbacks *cb;
+
+	p = &json->parse;
+	cb = &p->callbacks;
+
+	if (name && cb->onKey) {
+		if ((ret = cb->onKey(p->ctx, name, nameLen)) != JSON_ENONE) return ret;
+	}
+
+	switch (type) {
+		case JSON_NULL:
+			if (cb->onNull) return cb->onNull(p->ctx);
+			break;
+		case JSON_BOOLEAN:
+			if (cb->onBoolean) return cb->onBoolean(p->ctx, boolean);
+			break;
+		case JSON_INTEGER:
+			if (number->isUnsigned) {
+				if (cb->onUInteger64) return cb->onUInteger64(p->ctx, number->data.asUInt64);
+				if (cb->onFloat) return cb->onFloat(p->ctx, (double)number->data.asUInt64);
+			} else {
+				if (cb->onInteger64) return cb->onInteger64(p->ctx, number->data.asInt64);
+			}
+			break;
+		case JSON_FLOAT:
+			if (cb->onFloat) return cb->onFloat(p->ctx, number->data.asFloat);
+			break;
+		case JSON_STRING:
+			if (cb->onString) return cb->onString(p->ctx, value, valueLen);
+			break;
+		default:;
+	}
+
+	return JSON_ENONE;
+}
+
+/* decode a quoted name / string in place - it can only get shorter */
+json_err json_parseUnescape(unsigned char *str, unsigned int *len) {
+	json_err ret;
+
+	if (json_unescapeScan(str, *len) == *len) return JSON_ENONE;
+	if ((ret = json_unescape(str, *len, str, len)) != JSON_ENONE) return ret;
+	str[*len] = '\0';
+
+	return JSON_ENONE;
+}
+
 json_err json_parseHandleItem(struct json *json) {
 	json_err ret;
 	struct json_parse *p;
-	unsigned char c;
+	struct json_element *element;
+	enum json_dataTypes type;
 	char *name, *value;
-	int nameLen, valueLen;
-	unsigned char c_name, c_value;
+	unsigned int nameLen, valueLen;
+	unsigned int nameEnd = 0, valueEnd; /* where the terminators went, before any unescaping */
+	unsigned char c_name = 0, c_value;
+	unsigned char *data;
+	unsigned char small[8];
+	int borrow;
+	int boolean = 0;
+	struct json_number number;
+	struct json_projection *node;
 	
 	if (!json) return JSON_EMISSINGPARAM;
 	p = &json->parse;
+	borrow = !!(p->flags & PARSE_BORROW);
+	
+	value = &(p->buf.data[p->state.s_value]);
+	valueLen = valueEnd = p->state.e_value - p->state.s_value;
+	c_value = value[valueEnd];
+	value[valueEnd] = '\0';
 	
-	if (p->state.e_name == -2 || p->element->type == JSON_ARRAY) {
+	if (p->state.e_name == -2 || json_parseContainer(p) == JSON_ARRAY) {
 		name = NULL;
 	} else {
 		name = &(p->buf.data[p->state.s_name]);
-		nameLen = p->state.e_name - p->state.s_name;
-		c_name = name[nameLen];
-		name[nameLen] = '\0';
+		nameLen = nameEnd = p->state.e_name - p->state.s_name;
+		c_name = name[nameEnd];
+		name[nameEnd] = '\0';
+		if (p->state.q_name == 2 && (ret = json_parseUnescape((unsigned char *)name, &nameLen)) != JSON_ENONE) {
+			name[nameEnd] = c_name;
+			value[valueEnd] = c_value;
+			return ret;
+		}
 	}
 
-	value = &(p->buf.data[p->state.s_value]);
-	valueLen = p->state.e_value - p->state.s_value;
-	c_value = value[valueLen];
-	value[valueLen] = '\0';
-	
 	/* is it a string? */
 	if (p->state.q_value == 2) {
-		if ((ret = json_addString(p->element, "", name, value, valueLen)) != JSON_ENONE) return ret;
+		type = JSON_STRING;
 		goto taken;
 	}
 
 	/* is it an integer/float/hex? */
-	{	int i, d, h;
-		for (i = 0, d = 0, h = 0; i < valueLen; i++) {
-			if (i == 0) {
-				/* allow a sign for the first character */
-				if (value[i] == '-' || value [i] == '+') continue;
-				/* remember if the first character is an '0' - looking for a hex value */
-				if (value[i] == '0') h++;
-			} else if (i == 1) {
-				/* allow the second character to be an 'x', only if the first was an '0' - looking for a hex value */
-				if (value[i] == 'x' || value[i] == 'X') {
-					if (h != 1) goto not_number;;
-					h++;
-					continue;
-				}
-			} else if (i >= 2 && h == 2) {
-				switch (value[i]) {
-					case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
-					case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
-						continue;
-					default:;
-				}
-			}
-			if (value[i] == '.') {
-				if (h == 2) goto not_number;
-				d++;
-				continue;
-			}
-			if (!isdigit(value[i])) break;
-		}
-		if (i == valueLen) {
-			if (d == 0) {
-				if (h == 2) {
-					/* hex! -> integer */
-					int v;
-					value += 2;
-					valueLen -= 2;
-					if (sscanf(value, "%x", &v) != 1) return JSON_EINVAL;
-					if ((ret = json_addInteger(p->element, "", name, v)) != JSON_ENONE) return ret;
-					goto taken;
-				} else if (h < 2) {
-					/* integer! */
-					int v;
-					if (sscanf(value, "%d", &v) != 1) return JSON_EINVAL;
-					if ((ret = json_addInteger(p->element, "", name, v)) != JSON_ENONE) return ret;
-					goto taken;
-				}
-				goto not_number;
-			} else if (d == 1 && h < 2) {
-				/* float! */
-				double v;
-				if (sscanf(value, "%lf", &v) != 1) return JSON_EINVAL;
-				if ((ret = json_addFloat(p->element, "", name, v)) != JSON_ENONE) return ret;
-				goto taken;
-			}
-		}
+	if ((ret = json_numberParse(value, valueLen, &number)) == JSON_ENONE) {
+		type = number.type;
+		goto taken;
+	} else if (ret == JSON_ERANGE) {
+		/* it's a number, but it's too big to keep */
+		if (name) name[nameEnd] = c_name;
+		value[valueEnd] = c_value;
+		return ret;
 	}
-not_number:
+
 	
 	/* is it a null? */
 	if (!strncasecmp("null", value, 4)) {
-		if ((ret = json_addNull(p->element, "", name)) != JSON_ENONE) return ret;
+		type = JSON_NULL;
 		goto taken;
 	}
 	
 	/* is it a boolean? */
 	if (!strncasecmp("true", value, 4)) {
-		if ((ret = json_addBoolean(p->element, "", name, 1)) != JSON_ENONE) return ret;
+		type = JSON_BOOLEAN;
+		boolean = 1;
 		goto taken;
 	} else if (!strncasecmp("false", value, 5)) {
-		if ((ret = json_addBoolean(p->element, "", name, 0)) != JSON_ENONE) return ret;
+		type = JSON_BOOLEAN;
+		boolean = 0;
 		goto taken;
 	}
 
-	if (name) name[nameLen] = c_name;
-	value[valueLen] = c_value;
+	if (name) name[nameEnd] = c_name;
+	value[valueEnd] = c_value;
 
 	return JSON_EINVAL;
 	
 taken:
-	if (name) name[nameLen] = c_name;
-	value[valueLen] = c_value;
+	/* strings are decoded where they are, unless they are about to be copied out anyway */
+	ret = JSON_ENONE;
+	if (type == JSON_STRING && (borrow || (p->flags & PARSE_CALLBACKS) || p->projection)) {
+		ret = json_parseUnescape((unsigned char *)value, &valueLen);
+	}
+
+	/* a path that runs through a plain value doesn't lead anywhere */
+	if (ret != JSON_ENONE || !json_parseWanted(p, (unsigned char *)name, nameLen, &node) || (node && !node->all)) {
+		if (name) name[nameEnd] = c_name;
+		value[valueEnd] = c_value;
+		if (ret != JSON_ENONE) return ret;
+		goto done;
+	}
+
+	if (p->flags & PARSE_CALLBACKS) {
+		ret = json_parseCallValue(json, (unsigned char *)name, nameLen, type, (unsigned char *)value, valueLen, boolean, &number);
+		if (name) name[nameEnd] = c_name;
+		value[valueEnd] = c_value;
+		if (ret != JSON_ENONE) return ret;
+		goto done;
+	}
+
+	data = NULL;
+	if (type == JSON_STRING) {
+		if (borrow) {
+			/* the string stays where it is, and is already terminated */
+			data = value;
+		} else if (valueLen < sizeof(small)) {
+			/* it'll end up inside the element */
+			data = small;
+		} else if ((ret = json_arenaAlloc(&p->element->json->arena, valueLen + 1, (void **)&data)) != JSON_ENONE) {
+			data = NULL;
+		}
+		if (borrow || !data) {
+		} else if (p->projection) {
+			memcpy(data, value, valueLen + 1);
+		} else if ((ret = json_unescape(value, valueLen, data, &valueLen)) != JSON_ENONE) {
+			data = NULL;
+		} else {
+			data[valueLen] = '\0';
+		}
+	}
+	if (type != JSON_STRING || data) {
+		ret = json_elementAppend(p->element, name, nameLen, borrow, p->duplicates, &element);
+	}
+
+	if (name && (ret != JSON_ENONE || !borrow)) name[nameEnd] = c_name;
+	if (type != JSON_STRING || ret != JSON_ENONE || !borrow) value[valueEnd] = c_value;
+	if (ret != JSON_ENONE) return ret;
+
+	element->type = type;
+	switch (type) {
+		case JSON_STRING:
+			element->data_len = valueLen;
+			if (!borrow && valueLen < sizeof(element->data.asInline)) {
+				memcpy(element->data.asInline, data, valueLen + 1);
+				element->flags |= ELEMENT_INLINE;
+			} else {
+				element->data.asRaw = data;
+			}
+			break;
+		case JSON_BOOLEAN:
+			element->data.asInt = boolean;
+			break;
+		case JSON_INTEGER:
+			if (number.isUnsigned) {
+				element->flags |= ELEMENT_UNSIGNED;
+				element->data.asUInt64 = number.data.asUInt64;
+			} else {
+				element->data.asInt64 = number.data.asInt64;
+			}
+			break;
+		case JSON_FLOAT:
+			element->data.asFloat = number.data.asFloat;
+			break;
+		default:;
+	}
 	
+done:
 	memset(&p->state, 0, sizeof(p->state));
-	for (; p->pos < p->buf.pos; p->pos++) {
-		c = p->buf.data[p->pos];
-		if (c != ',' && !isspace(c)) break;
+	for (;;) {
+		p->pos = json_scanSkipSpace(&p->scan, &p->buf, p->pos);
+		if (p->pos >= p->buf.pos || p->buf.data[p->pos] != ',') break;
+		p->pos++;
 	}
 
 	return JSON_ENONE;
 }
 
+/* step over the rest of an object / array, just matching the brackets */
+json_err json_parseSkip(struct json *json) {
+	struct json_parse *p;
+	unsigned char c;
+	unsigned int i, j;
+
+	if (!json) return JSON_EMISSINGPARAM;
+	p = &json->parse;
+
+	while (p->skip.depth) {
+		i = json_scanNext(&p->scan, &p->buf, p->pos);
+		if (i >= p->buf.pos) {
+			p->pos = p->buf.pos;
+			return JSON_EINCOMPLETE;
+		}
+		p->pos = i + 1;
+		c = p->buf.data[i];
+
+		if (p->skip.quoted) {
+			if (c != '"') continue;
+			/* an odd number of '\'s means that the quote is escaped */
+			for (j = i; j > 0 && p->buf.data[j - 1] == '\\'; j--);
+			if ((i - j) & 1) continue;
+			p->skip.quoted = 0;
+		} else if (c == '"') {
+			p->skip.quoted = 1;
+		} else if (c == '{' || c == '[') {
+			p->skip.depth++;
+		} else if (c == '}' || c == ']') {
+			p->skip.depth--;
+		}
+	}
+
+	if (p->skip.element) {
+		p->skip.element->data.asUInt64 = p->skip.start;
+		p->skip.element->data_len = p->pos - p->skip.start;
+		p->skip.element = NULL;
+	}
+
+	return JSON_ENONE;
+}
+
+/* step 'pos' along to the next occurance of 'c', using the scanner's boundaries */
+json_err json_parseFind(struct json_parse *p, unsigned char c, unsigned int *found) {
+	unsigned int i;
+
+	for (;;) {
+		i = json_scanNext(&p->scan, &p->buf, p->pos);
+		if (i >= p->buf.pos) {
+			p->pos = p->buf.pos;
+			return JSON_EINCOMPLETE;
+		}
+		p->pos = i + 1;
+		if (p->buf.data[i] == c) break;
+	}
+	*found = i;
+
+	return JSON_ENONE;
+}
+
+/* find the quote that closes a string starting at 's' - one that follows an odd
+   run of backslashes is part of the string */
+json_err json_parseFindQuote(struct json_parse *p, unsigned int s, unsigned int *found) {
+	json_err ret;
+	unsigned int i, j;
+
+	for (;;) {
+		if ((ret = json_parseFind(p, '"', &i)) != JSON_ENONE) return ret;
+		for (j = i; j > s && p->buf.data[j - 1] == '\\'; j--);
+		if (!((i - j) & 1)) break;
+	}
+	*found = i;
+
+	return JSON_ENONE;
+}
+
 json_err json_parseGetName(struct json *json) {
+	json_err ret;
 	struct json_parse *p;
 	unsigned char c;
-	unsigned int s, e;
-	
+	unsigned int s, e, i;
+
 	if (!json) return JSON_EMISSINGPARAM;
 	p = &json->parse;
 	s = -1;
 	e = -1;
-	
+
 	if (p->state.s_name == 0) {
 		p->state.q_name = 0;
-		for (; s == -1 && p->state.q_name == 0 && p->pos < p->buf.pos; p->pos++) {
+		for (;;) {
+			p->pos = json_scanSkipSpace(&p->scan, &p->buf, p->pos);
+			if (p->pos >= p->buf.pos) return JSON_EINCOMPLETE;
 			c = p->buf.data[p->pos];
-			if (isspace(c) || c == ',') continue;
-			if (c == '{') {
+			if (c == ',') {
+				p->pos++;
+				continue;
+			} else if (c == '{') {
 				return json_parseHandleElement(json, JSON_OBJECT, NULL, 0);
 			} else if (c == '[') {
 				return json_parseHandleElement(json, JSON_ARRAY, NULL, 0);
 			} else if (c == '}' || c == ']') {
-				if (!p->element->parent) return JSON_ECOMPLETE;
-				p->element = p->element->parent;
+				if ((ret = json_parseHandleEnd(json)) != JSON_ENONE) return ret;
 				continue;
 			} else if (c == '"') {
 				p->state.q_name = 2;
@@ -213,135 +514,204 @@ json_err json_parseGetName(struct json *json) {
 			}
 			break;
 		}
-		if (s == -1 || p->state.q_name == 0) return JSON_EINCOMPLETE;
 		p->state.s_name = s;
 	} else {
 		s = p->state.s_name;
 	}
 
-	if (p->element->type == JSON_ARRAY) {
+	if (json_parseContainer(p) == JSON_ARRAY) {
 		e = -2;
 		p->state.i_colon = -2;
 		p->state.s_value = s;
 		p->state.q_value = p->state.q_name;
+	} else if (p->state.q_name == 2) {
+		if ((ret = json_parseFindQuote(p, s, &e)) != JSON_ENONE) return ret;
 	} else {
-		for (; e == -1 && p->pos < p->buf.pos; p->pos++) {
+		/* an unquoted identifier runs up to the next boundary */
+		i = json_scanNext(&p->scan, &p->buf, p->pos);
+		for (; p->pos < i; p->pos++) {
 			c = p->buf.data[p->pos];
-			if (p->state.q_name == 2) {
-				if (p->buf.data[p->pos] != '"') continue;
-				e = p->pos;
-				p->pos++;
-				break;
-			} else {
-				/* a ':' marks the end of the name */
-				if (c == ':') {
-					e = p->pos;
-					break;
-				}
-				/* first character of an unquoted identifier can't be a number */
-				if (p->pos == s && isdigit(c)) return JSON_EINVAL;
-				/* permit '_' */
-				if (c == '_') continue;
-				/* can't contain punctuation */
-				if (ispunct(c)) return JSON_EINVAL;
-				/* whitespace delimits the end of the identifier */
-				if (isspace(c)) {
-					e = p->pos;
-					break;
-				}
-			}
+			/* first character of an unquoted identifier can't be a number */
+			if (p->pos == s && isdigit(c)) return JSON_EINVAL;
+			/* permit '_' */
+			if (c == '_') continue;
+			/* can't contain punctuation */
+			if (ispunct(c)) return JSON_EINVAL;
 		}
+		if (i >= p->buf.pos) return JSON_EINCOMPLETE;
+		/* a ':' or whitespace marks the end of the name */
+		c = p->buf.data[i];
+		if (c != ':' && !isspace(c)) return JSON_EINVAL;
+		e = i;
 	}
-	if (e == -1) return JSON_EINCOMPLETE;
 	p->state.e_name = e;
-	
+
 	return JSON_ENONE;
 }
 
 json_err json_parseGetColon(struct json *json) {
+	json_err ret;
 	struct json_parse *p;
-	unsigned char c;
 	unsigned int i;
-	
+
 	if (!json) return JSON_EMISSINGPARAM;
 	p = &json->parse;
-	i = -1;
 
-	for (; i == -1 && p->pos < p->buf.pos; p->pos++) {
-		c = p->buf.data[p->pos];
-		if (isspace(c)) continue;
-		if (c == ':') {
-			i = p->pos;
-			p->pos++;
-			break;
-		}
-	}
-	if (i == -1) return JSON_EINCOMPLETE;
+	if ((ret = json_parseFind(p, ':', &i)) != JSON_ENONE) return ret;
 	p->state.i_colon = i;
 
 	return JSON_ENONE;
 }
 
 json_err json_parseGetValue(struct json *json) {
+	json_err ret;
 	struct json_parse *p;
 	unsigned char c;
-	unsigned int s, e;
-	
+	unsigned int s, e, i;
+
 	if (!json) return JSON_EMISSINGPARAM;
 	p = &json->parse;
-	s = -1;
-	e = -1;
-	
+
 	if (p->state.s_value == 0) {
 		p->state.q_value = 0;
-		for (; s == -1 && p->pos < p->buf.pos; p->pos++) {
-			c = p->buf.data[p->pos];
-			if (isspace(c)) continue;
-			if (c == '{') {
-				return json_parseHandleElement(json, JSON_OBJECT, &(p->buf.data[p->state.s_name]), p->state.e_name - p->state.s_name);
-			} else if (c == '[') {
-				return json_parseHandleElement(json, JSON_ARRAY, &(p->buf.data[p->state.s_name]), p->state.e_name - p->state.s_name);
-			} else if (c == '"') {
-				p->state.q_value = 2;
-				p->pos++;
-				s = p->pos;
-			} else {
-				p->state.q_value = 1;
-				s = p->pos;
-				p->pos++;
-			}
-			break;
+		p->pos = json_scanSkipSpace(&p->scan, &p->buf, p->pos);
+		if (p->pos >= p->buf.pos) return JSON_EINCOMPLETE;
+		c = p->buf.data[p->pos];
+		if (c == '{') {
+			return json_parseHandleElement(json, JSON_OBJECT, &(p->buf.data[p->state.s_name]), p->state.e_name - p->state.s_name);
+		} else if (c == '[') {
+			return json_parseHandleElement(json, JSON_ARRAY, &(p->buf.data[p->state.s_name]), p->state.e_name - p->state.s_name);
+		} else if (c == '"') {
+			p->state.q_value = 2;
+			p->pos++;
+			s = p->pos;
+		} else {
+			p->state.q_value = 1;
+			s = p->pos;
+			p->pos++;
 		}
-		if (s == -1) return JSON_EINCOMPLETE;
 		p->state.s_value = s;
-	} else {
-		s = p->state.s_value;
 	}
 
-	for (; e == -1 && p->pos < p->buf.pos; p->pos++) {
-		c = p->buf.data[p->pos];
-		if (p->state.q_value == 2) {
-			if (p->buf.data[p->pos] != '"') continue;
-			e = p->pos;
-			p->pos++;
-			break;
-		} else {
-			if (isspace(c) || c == ',' || c == ']' || c == '}') {
-				e = p->pos;
-				break;
+	if (p->state.q_value == 2) {
+		if ((ret = json_parseFindQuote(p, p->state.s_value, &e)) != JSON_ENONE) return ret;
+	} else {
+		/* an unquoted value ends at whitespace, or the end of the item / element */
+		for (;;) {
+			i = json_scanNext(&p->scan, &p->buf, p->pos);
+			if (i >= p->buf.pos) {
+				p->pos = p->buf.pos;
+				return JSON_EINCOMPLETE;
 			}
+			c = p->buf.data[i];
+			if (isspace(c) || c == ',' || c == ']' || c == '}') break;
+			p->pos = i + 1;
 		}
+		p->pos = i;
+		e = i;
 	}
-	if (e == -1) return JSON_EINCOMPLETE;
 	p->state.e_value = e;
 
 	return JSON_ENONE;
 }
 
+/* drop everything from the buffer that has already been turned into elements.
+   only the current token (if any) is kept, along with the byte before it so that
+   none of the positions held in the state end up as 0 (which means 'not found yet') */
+json_err json_parseCompact(struct json *json) {
+	json_err ret;
+	struct json_parse *p;
+	unsigned int keep, d;
+
+	if (!json) return JSON_EMISSINGPARAM;
+	p = &json->parse;
+
+	/* we haven't found the start of the JSON yet */
+	if (p->pos == 0) return JSON_ENONE;
+	/* lazy elements point into the buffer - only throw away documents that are finished */
+	if ((p->flags & PARSE_LAZY) && p->stack.pos) return JSON_ENONE;
+
+	keep = p->state.s_name ? p->state.s_name : p->pos;
+	/* a run of '\\'s decides whether the next quote is escaped, so keep all of it */
+	while (keep > 0 && p->buf.data[keep - 1] == '\\') keep--;
+	if (keep == 0) return JSON_ENONE;
+	d = keep - 1;
+
+	/* only bother when there is more to drop than there is to keep */
+	if (d <= p->buf.pos - d) return JSON_ENONE;
+	if ((ret = json_bufDiscard(&p->buf, d)) != JSON_ENONE) return ret;
+
+	p->pos -= d;
+	if (p->state.s_name) p->state.s_name -= d;
+	if (p->state.e_name && p->state.e_name != -2) p->state.e_name -= d;
+	if (p->state.i_colon && p->state.i_colon != -2) p->state.i_colon -= d;
+	if (p->state.s_value) p->state.s_value -= d;
+	if (p->state.e_value) p->state.e_value -= d;
+	json_scanReset(&p->scan);
+
+	return JSON_ENONE;
+}
+
+/* look for the start of the next document */
+json_err json_parseStart(struct json *json) {
+	struct json_parse *p;
+
+	if (!json) return JSON_EMISSINGPARAM;
+	p = &json->parse;
+
+	/* make sure we have JSON - must start with a '{' */
+	p->pos = json_scanSkipSpace(&p->scan, &p->buf, p->pos);
+	if (p->pos >= p->buf.pos) return JSON_EINCOMPLETE;
+	if (p->buf.data[p->pos] == '[' && (p->flags & PARSE_ARRAYROOT)) {
+		return json_parseHandleElement(json, JSON_ARRAY, NULL, 0);
+	}
+	if (p->buf.data[p->pos] != '{') {
+		/* between documents, this is just wrong */
+		if (p->flags & PARSE_STREAM) return JSON_EINVAL;
+		/* otherwise throw it all away, and hope that the real thing follows */
+		p->pos = 0;
+		p->buf.pos = 0;
+		json_scanReset(&p->scan);
+		return JSON_EINCOMPLETE;
+	}
+
+	/* step over the initial object */
+	return json_parseHandleElement(json, JSON_OBJECT, NULL, 0);
+}
+
+/* a document is complete - hand it over, and get ready for the next one */
+json_err json_parseDocument(struct json *json) {
+	json_err ret;
+	struct json_parse *p;
+	struct json_element *root;
+
+	if (!json) return JSON_EMISSINGPARAM;
+	p = &json->parse;
+	root = json->root;
+
+	if (p->onDocument) {
+		if ((ret = p->onDocument(p->documentCtx, root)) != JSON_ENONE) return ret;
+	}
+
+	/* nothing outlives the document, so start the arena again rather than taking it apart */
+	json_arenaReset(&json->arena);
+	json_mapClear(&json->userData);
+	json_indexFreeAll(json);
+	json_internReset(json);
+	root->flags &= ~(ELEMENT_USERDATA | ELEMENT_INDEXED);
+	root->child_head = NULL;
+	root->child_count = 0;
+	root->type = JSON_OBJECT;
+
+	p->element = root;
+	memset(&p->state, 0, sizeof(p->state));
+
+	return JSON_ENONE;
+}
+
 json_err json_parseRun(struct json *json) {
 	json_err ret;
 	struct json_parse *p;
-	unsigned char c;
 	unsigned int prev_pos;
 	
 	if (!json) return JSON_EMISSINGPARAM;
@@ -350,37 +720,45 @@ json_err json_parseRun(struct json *json) {
 	if (!p->buf.data || p->buf.pos == 0) return JSON_EINCOMPLETE;
 	if (!p->element) p->element = json->root;
 	
-	if (p->pos == 0) {
-		/* make sure we have JSON - must start with a '{' */
-		for (;p->pos < p->buf.pos; p->pos++) {
-			c = p->buf.data[p->pos];
-			if (isspace(c)) continue;
-			if (c == '{') break;
-			p->pos = 0;
-			p->buf.pos = 0;
-		}
-		if (c != '{') return JSON_EINCOMPLETE;
-		p->pos++; /* step over the initial object */
-	}
-	
-	for (prev_pos = 0; p->pos < p->buf.pos;) {
-		if (p->state.e_name && p->state.e_value) {
-			if ((ret = json_parseHandleItem(json)) != JSON_ENONE) return ret;
+	for (;;) {
+		if (p->stack.pos == 0) {
+			if ((ret = json_parseStart(json)) != JSON_ENONE) return ret;
 		}
 		
-		if (prev_pos == p->pos) return JSON_EINCOMPLETE;
-		prev_pos = p->pos;
-
-		if (!p->state.e_name) {
-			if ((ret = json_parseGetName(json)) != JSON_ENONE) return ret;
-		} else if (!p->state.i_colon) {
-			if ((ret = json_parseGetColon(json)) != JSON_ENONE) return ret;
-		} else if (!p->state.e_value) {
-			if ((ret = json_parseGetValue(json)) != JSON_ENONE) return ret;
+		ret = JSON_ENONE;
+		for (prev_pos = -1; p->pos < p->buf.pos;) {
+			if (p->skip.depth) {
+				if ((ret = json_parseSkip(json)) != JSON_ENONE) break;
+				continue;
+			}
+			
+			if (p->state.e_name && p->state.e_value) {
+				if ((ret = json_parseHandleItem(json)) != JSON_ENONE) break;
+				/* the item may have ended right where we are, that's still progress */
+				prev_pos = -1;
+				continue;
+			}
+			
+			if (prev_pos == p->pos) {
+				ret = JSON_EINCOMPLETE;
+				break;
+			}
+			prev_pos = p->pos;
+			
+			if (!p->state.e_name) {
+				if ((ret = json_parseGetName(json)) != JSON_ENONE) break;
+			} else if (!p->state.i_colon) {
+				if ((ret = json_parseGetColon(json)) != JSON_ENONE) break;
+			} else if (!p->state.e_value) {
+				if ((ret = json_parseGetValue(json)) != JSON_ENONE) break;
+			}
 		}
+		if (ret == JSON_ENONE) return ret;
+		
+		/* with a stream, keep going with the next document */
+		if (ret != JSON_ECOMPLETE || !(p->flags & PARSE_STREAM)) return ret;
+		if ((ret = json_parseDocument(json)) != JSON_ENONE) return ret;
 	}
-	
-	return JSON_ENONE;
 }
 
 EXPORT json_err json_dataAdd(struct json *json, const unsigned char *data, unsigned int len) {
@@ -388,6 +766,7 @@ EXPORT json_err json_dataAdd(struct json *json, const unsigned char *data, unsig
 	
 	if (!json || !data) return JSON_EMISSINGPARAM;
 	if (len == 0) return JSON_ENONE;
+	if (json->parse.flags & PARSE_BORROW) return JSON_EINVAL;
 	switch (json->parse.err) {
 		case JSON_ENONE:
 		case JSON_EINCOMPLETE:
@@ -396,7 +775,220 @@ EXPORT json_err json_dataAdd(struct json *json, const unsigned char *data, unsig
 			return json->parse.err;
 	}
 	
+	if ((ret = json_scanInit(&json->parse.scan)) != JSON_ENONE) return ret;
+	if ((ret = json_parseCompact(json)) != JSON_ENONE) return ret;
 	if ((ret = json_bufImport(&json->parse.buf, data, len)) != JSON_ENONE) return ret;
 	
 	return (json->parse.err = json_parseRun(json));
 }
+
+/* parse a complete document in place. names and strings are left in the buffer rather
+   than being copied out, so the buffer is written to, and must outlive the document */
+json_err json_parseInPlace(struct json *json, unsigned char *data, unsigned int len, unsigned int flags) {
+	json_err ret;
+	struct json_parse *p;
+
+	if (!json || !data) return JSON_EMISSINGPARAM;
+	p = &json->parse;
+
+	/* the document must not have been fed any data already */
+	if (p->buf.pos || p->err != JSON_ENONE) return JSON_EINVAL;
+	if ((ret = json_scanInit(&p->scan)) != JSON_ENONE) return ret;
+
+	/* a buffer that was kept by json_reset() isn't any use here */
+	json_free(&json->allocator, p->buf.data);
+	p->flags |= flags;
+	p->buf.data = data;
+	p->buf.len = len;
+	p->buf.pos = len;
+
+	return (p->err = json_parseRun(json));
+}
+
+EXPORT json_err json_dataBorrow(struct json *json, unsigned char *data, unsigned int len) {
+	return json_parseInPlace(json, data, len, PARSE_BORROW);
+}
+
+EXPORT json_err json_dataAdopt(struct json *json, unsigned char *data, unsigned int len) {
+	return json_parseInPlace(json, data, len, PARSE_BORROW | PARSE_ADOPT);
+}
+
+/* parse the children of a lazy element */
+json_err json_parseExpand(struct json_element *element) {
+	json_err ret;
+	struct json *json;
+	struct json tmp;
+
+	if (!element) return JSON_EMISSINGPARAM;
+	if (!(element->flags & ELEMENT_LAZY)) return JSON_ENONE;
+	/* we've tried before, and the bytes it was parsed from have been written over since */
+	if (element->flags & ELEMENT_FAILED) return (json_err)element->data.asInt;
+	/* we're still looking for the end of it */
+	if (element->data_len == 0) return JSON_EINCOMPLETE;
+	json = element->json;
+
+	/* run a parser over just this bit of the buffer, with the element as its root */
+	memset(&tmp, 0, sizeof(tmp));
+	tmp.root = element;
+	tmp.parse.flags = (json->parse.flags & (PARSE_BORROW | PARSE_LAZY)) | PARSE_ARRAYROOT;
+	tmp.parse.duplicates = json->parse.duplicates;
+	tmp.parse.buf.data = json->parse.buf.data;
+	tmp.parse.buf.len = json->parse.buf.len;
+	tmp.parse.buf.pos = element->data.asUInt64 + element->data_len;
+	tmp.parse.pos = element->data.asUInt64;
+	tmp.parse.scan.allocator = &json->allocator;
+	tmp.parse.stack.allocator = &json->allocator;
+	if ((ret = json_scanInit(&tmp.parse.scan)) != JSON_ENONE) return ret;
+
+	element->flags &= ~ELEMENT_LAZY;
+	ret = json_parseRun(&tmp);
+
+	json_scanFree(&tmp.parse.scan);
+	json_free(&json->allocator, tmp.parse.stack.data);
+
+	if (ret != JSON_ECOMPLETE) {
+		/* names and strings have been terminated / unescaped in place, so it can't be tried
+		   again - keep the error, and give it back from now on */
+		if (ret == JSON_ENONE || ret == JSON_EINCOMPLETE) ret = JSON_EINVAL;
+		if (element->child_head) json_elementDestroy(element->child_head);
+		element->child_head = NULL;
+		element->child_count = 0;
+		json_indexFree(element);
+		element->flags |= ELEMENT_LAZY | ELEMENT_FAILED;
+		element->data.asInt = ret;
+		return ret;
+	}
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_parseFile(struct json *json, const char *path) {
+	json_err ret;
+	struct stat st;
+	unsigned char *map;
+	int fd;
+
+	if (!json || !path) return JSON_EMISSINGPARAM;
+	if (json->parse.buf.pos || json->parse.err != JSON_ENONE) return JSON_EINVAL;
+
+	if ((fd = open(path, O_RDONLY)) < 0) return JSON_EMISSING;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return JSON_EUNKNOWN;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return JSON_EINCOMPLETE;
+	}
+	if ((unsigned long long)st.st_size >= UINT_MAX) {
+		close(fd);
+		return JSON_ERANGE;
+	}
+
+	/* a private mapping - the '\0's that terminate names and strings never reach the file */
+	map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) return JSON_ENOMEM;
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+	madvise(map, st.st_size, MADV_WILLNEED);
+
+	ret = json_parseInPlace(json, map, st.st_size, PARSE_BORROW | PARSE_MAPPED);
+
+	/* if the document didn't take it, it's still ours */
+	if (json->parse.buf.data != map) munmap(map, st.st_size);
+
+	return ret;
+}
+
+EXPORT json_err json_setLazy(struct json *json, int lazy) {
+	if (!json) return JSON_EMISSINGPARAM;
+
+	/* too late - the parse has already started */
+	if (json->parse.buf.pos || json->parse.err != JSON_ENONE) return JSON_EINVAL;
+
+	if (lazy) {
+		json->parse.flags |= PARSE_LAZY;
+	} else {
+		json->parse.flags &= ~PARSE_LAZY;
+	}
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_setProjection(struct json *json, unsigned char **paths) {
+	json_err ret;
+	struct json_projection *projection;
+
+	if (!json || !paths) return JSON_EMISSINGPARAM;
+
+	/* too late - the parse has already started */
+	if (json->parse.buf.pos || json->parse.err != JSON_ENONE) return JSON_EINVAL;
+
+	if ((ret = json_projectionCompile(&json->allocator, paths, &projection)) != JSON_ENONE) return ret;
+	json_projectionFree(&json->allocator, json->parse.projection);
+	json->parse.projection = projection;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_setDuplicatePolicy(struct json *json, enum json_duplicatePolicy policy) {
+	if (!json) return JSON_EMISSINGPARAM;
+
+	switch (policy) {
+		case JSON_DUPLICATE_REJECT:
+		case JSON_DUPLICATE_REPLACE:
+		case JSON_DUPLICATE_TRUST:
+			break;
+		default:
+			return JSON_EINVAL;
+	}
+	json->parse.duplicates = policy;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_setBufferGrowth(struct json *json, unsigned int percent) {
+	if (!json) return JSON_EMISSINGPARAM;
+
+	/* this can change at any time - it only affects the next time that a buffer runs out */
+	json->parse.buf.growth = percent;
+	json->parse.stack.growth = percent;
+	json->parse.levels.growth = percent;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_setIndexWidth(struct json *json, unsigned int width) {
+	if (!json) return JSON_EMISSINGPARAM;
+
+	/* this can change at any time - objects that already have an index keep it */
+	json->indexWidth = width;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_setCallbacks(struct json *json, const struct json_callbacks *callbacks, void *ctx) {
+	if (!json || !callbacks) return JSON_EMISSINGPARAM;
+
+	/* too late - the parse has already started */
+	if (json->parse.buf.pos || json->parse.err != JSON_ENONE) return JSON_EINVAL;
+
+	json->parse.callbacks = *callbacks;
+	json->parse.ctx = ctx;
+	json->parse.flags |= PARSE_CALLBACKS;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_setDocumentCallback(struct json *json, json_err (*onDocument)(void *ctx, struct json_element *root), void *ctx) {
+	if (!json) return JSON_EMISSINGPARAM;
+
+	/* too late - the parse has already started */
+	if (json->parse.buf.pos || json->parse.err != JSON_ENONE) return JSON_EINVAL;
+
+	json->parse.onDocument = onDocument;
+	json->parse.documentCtx = ctx;
+	json->parse.flags |= PARSE_STREAM;
+
+	return JSON_ENONE;
+}
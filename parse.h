@@ -20,9 +20,14 @@
 	along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+json_err json_parseUnescape(unsigned char *str, unsigned int *len);
+json_err json_parseFindQuote(struct json_parse *p, unsigned int s, unsigned int *found);
 json_err json_parseGetName(struct json *json);
 json_err json_parseGetColon(struct json *json);
 json_err json_parseGetValue(struct json *json);
 json_err json_parseRun(struct json *json);
+json_err json_parseCompact(struct json *json);
+json_err json_parseExpand(struct json_element *element);
+json_err json_parseInPlace(struct json *json, unsigned char *data, unsigned int len, unsigned int flags);
 
 #endif /* __PARSE_H */
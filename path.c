@@ -0,0 +1,170 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <ctype.h>
+
+#include "json_int.h"
+#include "path.h"
+#include "add.h"
+#include "element.h"
+#include "parse.h"
+#include "intern.h"
+
+/* read the first segment of 'identifier'. 'next' is left at the rest of it, or is NULL if
+   there was nothing left to read */
+json_err json_pathNext(unsigned char *identifier, struct json_pathSegment *segment, unsigned char **next) {
+	json_err ret;
+	unsigned char *identifierStart, *identifierEnd;
+	enum identifierType idType;
+	unsigned char *t;
+
+	/* skip over the white space */
+	for (t = identifier; *t == ' '; t++);
+
+	if (*t == '\0') {
+		*next = NULL;
+		return JSON_ENONE;
+	}
+
+	if (*t == '[') { /* handle the array identifier */
+		/* for simplicity, this will not resolve strings or floating point numbers, it will ONLY handle positive integer indexes
+		   if you want to dig into an object, then use a freaking dot */
+		unsigned int index = 0;
+
+		t++;
+
+		if ((ret = json_identifyAsArray(t, &identifierStart, &identifierEnd, &idType)) != JSON_ENONE) return ret;
+
+		switch (idType) {
+			case ID_INVALID: return JSON_EINVAL;
+
+			case ID_NUMBER: /* simple offset, counting from zero being the left-most sibling */
+				/* read it where it is, rather than copying it out for sscanf() */
+				for (index = 0, t = identifierStart; t <= identifierEnd && isdigit(*t); t++) {
+					if (index > (UINT_MAX - (*t - '0')) / 10) return JSON_EINVAL;
+					index = (index * 10) + (*t - '0');
+				}
+				break;
+
+			case ID_IDENTIFIER: /* e.g: "a[b]" - an index that would need to be looked up first isn't supported */
+				return JSON_ENOTIMPLEMENTED;
+		}
+
+		segment->name = NULL;
+		segment->nameLen = 0;
+		segment->hash = 0;
+		segment->index = index;
+		if (*identifierEnd != '\0') identifierEnd++;
+
+	} else {
+		if ((ret = json_identifyAsElement(t, &identifierStart, &identifierEnd, &idType)) != JSON_ENONE) return ret;
+
+		segment->name = identifierStart;
+		segment->nameLen = identifierEnd - identifierStart + 1;
+		segment->hash = json_internHash(segment->name, segment->nameLen);
+		segment->index = 0;
+	}
+
+	/* now that we are done with the identifier, move it along */
+	if (*identifierEnd != '\0') identifierEnd++;
+	if (*identifierEnd != '\0' && *identifierEnd == '.') identifierEnd++;
+
+	*next = identifierEnd;
+
+	return JSON_ENONE;
+}
+
+/* follow one segment down from 'parent' */
+json_err json_pathStep(struct json_element *parent, struct json_pathSegment *segment, struct json_element **targetRet) {
+	json_err ret;
+	struct json_element *target;
+
+	/* we're going in, so the children had better be there */
+	if ((ret = json_parseExpand(parent)) != JSON_ENONE) return ret;
+
+	if (segment->name) {
+		/* only objects have named members */
+		if (parent->type != JSON_OBJECT) return JSON_EMISSING;
+		target = json_elementFindChild(parent, segment->name, segment->nameLen, segment->hash);
+	} else {
+		target = json_elementChild(parent, segment->index);
+	}
+
+	/* check that we actually found something */
+	if (!target) return JSON_EMISSING;
+
+	*targetRet = target;
+
+	return JSON_ENONE;
+}
+
+json_err json_pathElement(struct json_element *root, struct json_path *path, struct json_element **targetRet) {
+	json_err ret;
+	unsigned int i;
+
+	for (i = 0; i < path->count; i++) {
+		if ((ret = json_pathStep(root, &(path->segments[i]), &root)) != JSON_ENONE) return ret;
+	}
+
+	if (targetRet) *targetRet = root;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_pathCompile(const unsigned char *identifier, struct json_path **pathRet) {
+	json_err ret;
+	struct json_path *path;
+	struct json_pathSegment segment;
+	unsigned char *t, *copy;
+	unsigned int count;
+	size_t len;
+
+	if (!identifier || !pathRet) return JSON_EMISSINGPARAM;
+
+	/* count the segments first, so that the whole thing can be one allocation */
+	for (count = 0, t = (unsigned char *)identifier;; count++) {
+		if ((ret = json_pathNext(t, &segment, &t)) != JSON_ENONE) return ret;
+		if (!t) break;
+	}
+
+	len = strlen((char *)identifier);
+	if ((path = json_alloc(NULL, sizeof(*path) + (sizeof(*path->segments) * count) + len + 1)) == NULL) return JSON_ENOMEM;
+	path->count = count;
+
+	/* the names point into our own copy, rather than the caller's */
+	copy = (unsigned char *)&(path->segments[count]);
+	memcpy(copy, identifier, len + 1);
+	for (count = 0, t = copy; count < path->count; count++) {
+		json_pathNext(t, &(path->segments[count]), &t);
+	}
+
+	*pathRet = path;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_pathFree(struct json_path *path) {
+	if (!path) return JSON_EMISSINGPARAM;
+	json_free(NULL, path);
+	return JSON_ENONE;
+}
@@ -0,0 +1,44 @@
+#ifndef __PATH_H
+#define __PATH_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+
+/* one step along an identifier - either a named member, or an array index */
+struct json_pathSegment {
+	unsigned char *name; /* NULL for an array index */
+	unsigned int nameLen;
+	uint32_t hash;       /* json_internHash() of the name */
+	unsigned int index;
+};
+
+/* an identifier that has been read once by json_pathCompile(). the names point into
+   the copy of the identifier that follows the segments */
+struct json_path {
+	unsigned int count;
+	struct json_pathSegment segments[];
+};
+
+json_err json_pathNext(unsigned char *identifier, struct json_pathSegment *segment, unsigned char **next);
+json_err json_pathStep(struct json_element *parent, struct json_pathSegment *segment, struct json_element **target);
+json_err json_pathElement(struct json_element *root, struct json_path *path, struct json_element **target);
+
+#endif /* __PATH_H */
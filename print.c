@@ -24,6 +24,8 @@
 #include "json_int.h"
 #include "print.h"
 #include "buf.h"
+#include "parse.h"
+#include "element.h"
 
 //#define PRINT_WHITESPACE
 
@@ -90,7 +92,11 @@ json_err _json_printBoolean(struct json_print_ctx *ctx) {
 
 json_err _json_printInteger(struct json_print_ctx *ctx) {
 	if (!ctx || !ctx->root || !ctx->buf) return JSON_EMISSINGPARAM;
-	json_bufPrintf(ctx->buf, "%d", ctx->root->data.asInt);
+	if (ctx->root->flags & ELEMENT_UNSIGNED) {
+		json_bufPrintf(ctx->buf, "%llu", (unsigned long long)ctx->root->data.asUInt64);
+	} else {
+		json_bufPrintf(ctx->buf, "%lld", (long long)ctx->root->data.asInt64);
+	}
 	return JSON_ENONE;
 }
 
@@ -100,10 +106,39 @@ json_err _json_printFloat(struct json_print_ctx *ctx) {
 	return JSON_ENONE;
 }
 
+/* strings are held decoded, so put the escapes back on the way out */
+json_err _json_printQuoted(struct json_print_ctx *ctx, const unsigned char *str, unsigned int len) {
+	unsigned int i, s;
+	unsigned char c;
+
+	if (!ctx || !ctx->buf) return JSON_EMISSINGPARAM;
+	json_bufPrintf(ctx->buf, "\"");
+	for (i = s = 0; i < len; i++) {
+		c = str[i];
+		if (c >= 0x20 && c != '"' && c != '\\') continue;
+		if (i > s) json_bufImport(ctx->buf, &(str[s]), i - s);
+		s = i + 1;
+		switch (c) {
+			case '"':  json_bufPrintf(ctx->buf, "\\\""); break;
+			case '\\': json_bufPrintf(ctx->buf, "\\\\"); break;
+			case '\b': json_bufPrintf(ctx->buf, "\\b");  break;
+			case '\f': json_bufPrintf(ctx->buf, "\\f");  break;
+			case '\n': json_bufPrintf(ctx->buf, "\\n");  break;
+			case '\r': json_bufPrintf(ctx->buf, "\\r");  break;
+			case '\t': json_bufPrintf(ctx->buf, "\\t");  break;
+			default:   json_bufPrintf(ctx->buf, "\\u%04x", c); break;
+		}
+	}
+	if (i > s) json_bufImport(ctx->buf, &(str[s]), i - s);
+	json_bufPrintf(ctx->buf, "\"");
+
+	return JSON_ENONE;
+}
+
 json_err _json_printString(struct json_print_ctx *ctx) {
 	if (!ctx || !ctx->root || !ctx->buf) return JSON_EMISSINGPARAM;
-	if (ctx->root->data.asRaw) {
-		json_bufPrintf(ctx->buf, "\"%s\"", ctx->root->data.asRaw);
+	if ((ctx->root->flags & ELEMENT_INLINE) || ctx->root->data.asRaw) {
+		_json_printQuoted(ctx, json_elementString(ctx->root), ctx->root->data_len);
 	} else {
 		json_bufPrintf(ctx->buf, "\"\"");
 	}
@@ -122,14 +157,14 @@ json_err _json_printObject(struct json_print_ctx *ctx) {
 
 	if (!ctx || !ctx->root || !ctx->buf) return JSON_EMISSINGPARAM;
 	o = ctx->root;
+	if ((ret = json_parseExpand(o)) != JSON_ENONE) return ret;
 	json_bufPrintf(ctx->buf, "{");
 #ifdef NEW_LINE
 	json_bufPrintf(ctx->buf, NEW_LINE);
 #endif
 	ctx->tab_depth++;
 
-	for (i = o->child_head; i && i->sibling_prev; i = i->sibling_prev);
-	for (c = 0; i; i = i->sibling_next, c++) {
+	for (c = 0, i = o->child_head; i; i = i->sibling_next, c++) {
 		if (c) {
 			json_bufPrintf(ctx->buf, ",");
 #ifdef NEW_LINE
@@ -145,7 +180,10 @@ json_err _json_printObject(struct json_print_ctx *ctx) {
 			}
 		}
 		ctx->root = i;
-		if (i->name) json_bufPrintf(ctx->buf, "\"%s\":", i->name);
+		if (i->name) {
+			_json_printQuoted(ctx, i->name, i->name_len);
+			json_bufPrintf(ctx->buf, ":");
+		}
 		if ((ret = _json_printElement(ctx)) != JSON_ENONE) return ret;
 	}
 
@@ -171,9 +209,9 @@ json_err _json_printArray(struct json_print_ctx *ctx) {
 
 	if (!ctx || !ctx->root || !ctx->buf) return JSON_EMISSINGPARAM;
 	o = ctx->root;
+	if ((ret = json_parseExpand(o)) != JSON_ENONE) return ret;
 
-	for (i = o->child_head; i && i->sibling_prev; i = i->sibling_prev);
-	for (c = 0; i; i = i->sibling_next, c++) {
+	for (c = 0, i = o->child_head; i; i = i->sibling_next, c++) {
 		if (c) {
 			json_bufPrintf(ctx->buf, ",");
 #ifdef NEW_LINE
@@ -207,6 +245,7 @@ EXPORT json_err json_printElement(struct json_element *root, unsigned char **out
 
 	memset(&ctx, 0, sizeof(ctx));
 	memset(&buf, 0, sizeof(buf));
+	buf.growth = root->json->parse.buf.growth;
 	ctx.root = root;
 	ctx.buf = &buf;
 
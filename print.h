@@ -31,6 +31,7 @@ json_err _json_printNull(struct json_print_ctx *ctx);
 json_err _json_printBoolean(struct json_print_ctx *ctx);
 json_err _json_printInteger(struct json_print_ctx *ctx);
 json_err _json_printFloat(struct json_print_ctx *ctx);
+json_err _json_printQuoted(struct json_print_ctx *ctx, const unsigned char *str, unsigned int len);
 json_err _json_printString(struct json_print_ctx *ctx);
 json_err _json_printFunction(struct json_print_ctx *ctx);
 json_err _json_printObject(struct json_print_ctx *ctx);
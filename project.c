@@ -0,0 +1,131 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_int.h"
+#include "project.h"
+#include "path.h"
+
+static json_err json_projectionNew(const struct json_allocator *allocator, struct json_projection *parent, unsigned char *name, unsigned int nameLen, unsigned int index, struct json_projection **nodeRet) {
+	struct json_projection *node;
+
+	if ((node = json_alloc(allocator, sizeof(*node) + (name ? nameLen + 1 : 0))) == NULL) return JSON_ENOMEM;
+	memset(node, 0, sizeof(*node));
+
+	if (name) {
+		node->name = (unsigned char *)&(node[1]);
+		memcpy(node->name, name, nameLen);
+		node->name[nameLen] = '\0';
+		node->nameLen = nameLen;
+	}
+	node->index = index;
+
+	if (parent) {
+		node->next = parent->child;
+		parent->child = node;
+	}
+
+	*nodeRet = node;
+
+	return JSON_ENONE;
+}
+
+/* add a single path to the tree, read the same way as json_getElement()'s identifiers */
+static json_err json_projectionAdd(const struct json_allocator *allocator, struct json_projection *root, unsigned char *path) {
+	json_err ret;
+	struct json_pathSegment segment;
+	struct json_projection *node, *child;
+	unsigned char *t;
+
+	node = root;
+	for (t = path;;) {
+		if ((ret = json_pathNext(t, &segment, &t)) != JSON_ENONE) return ret;
+		if (!t) break;
+
+		/* once the whole of something is wanted, there's no need to go any deeper */
+		if (node->all) return JSON_ENONE;
+
+		if (segment.name) {
+			for (child = node->child; child && (!child->name || child->nameLen != segment.nameLen || memcmp(child->name, segment.name, segment.nameLen)); child = child->next);
+		} else {
+			for (child = node->child; child && (child->name || child->index != segment.index); child = child->next);
+		}
+		if (!child && (ret = json_projectionNew(allocator, node, segment.name, segment.nameLen, segment.index, &child)) != JSON_ENONE) return ret;
+
+		node = child;
+	}
+
+	/* the end of the path - keep everything below here, and drop anything more specific */
+	json_projectionFree(allocator, node->child);
+	node->child = NULL;
+	node->all = 1;
+
+	return JSON_ENONE;
+}
+
+json_err json_projectionCompile(const struct json_allocator *allocator, unsigned char **paths, struct json_projection **rootRet) {
+	json_err ret;
+	struct json_projection *root;
+	unsigned int i;
+
+	if (!paths || !rootRet) return JSON_EMISSINGPARAM;
+
+	if ((ret = json_projectionNew(allocator, NULL, NULL, 0, 0, &root)) != JSON_ENONE) return ret;
+
+	for (i = 0; paths[i]; i++) {
+		if ((ret = json_projectionAdd(allocator, root, paths[i])) != JSON_ENONE) {
+			json_projectionFree(allocator, root);
+			return ret;
+		}
+	}
+
+	*rootRet = root;
+
+	return JSON_ENONE;
+}
+
+void json_projectionFree(const struct json_allocator *allocator, struct json_projection *node) {
+	struct json_projection *next;
+
+	for (; node; node = next) {
+		next = node->next;
+		json_projectionFree(allocator, node->child);
+		json_free(allocator, node);
+	}
+}
+
+/* where does the named / indexed member of 'node' lead? NULL means that it isn't wanted */
+struct json_projection *json_projectionFind(struct json_projection *node, const unsigned char *name, unsigned int nameLen, unsigned int index) {
+	struct json_projection *child;
+
+	if (!node || node->all) return node;
+
+	for (child = node->child; child; child = child->next) {
+		if (name) {
+			if (child->name && child->nameLen == nameLen && !memcmp(child->name, name, nameLen)) break;
+		} else {
+			if (!child->name && child->index == index) break;
+		}
+	}
+
+	return child;
+}
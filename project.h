@@ -0,0 +1,43 @@
+#ifndef __PROJECT_H
+#define __PROJECT_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* the paths that json_setProjection() asked for, as a tree */
+struct json_projection {
+	unsigned char *name; /* NULL for an array index */
+	unsigned int nameLen;
+	unsigned int index;
+	int all; /* the end of a path - everything below here is wanted */
+	struct json_projection *child;
+	struct json_projection *next;
+};
+
+/* where the parser is up to in the tree, for each open object / array */
+struct json_projectionLevel {
+	struct json_projection *node;
+	unsigned int index; /* the next array index */
+};
+
+json_err json_projectionCompile(const struct json_allocator *allocator, unsigned char **paths, struct json_projection **root);
+void json_projectionFree(const struct json_allocator *allocator, struct json_projection *node);
+struct json_projection *json_projectionFind(struct json_projection *node, const unsigned char *name, unsigned int nameLen, unsigned int index);
+
+#endif /* __PROJECT_H */
@@ -0,0 +1,472 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <ctype.h>
+
+#include "json_int.h"
+#include "query.h"
+#include "element.h"
+#include "intern.h"
+#include "parse.h"
+
+struct json_queryParser {
+	unsigned char *t;
+	struct json_query *query; /* the steps and segments are NULL while they are being counted */
+	unsigned int steps;
+	unsigned int segments;
+	struct json_queryStep spareStep;
+	struct json_pathSegment spareSegment;
+};
+
+struct json_queryRunner {
+	struct json_query *query;
+	json_err (*onMatch)(void *ctx, struct json_element *element);
+	void *ctx;
+};
+
+#define json_querySkip(t) for (; *(t) == ' '; (t)++)
+
+static void json_queryNameSegment(struct json_pathSegment *segment, unsigned char *name, unsigned int nameLen) {
+	segment->name = name;
+	segment->nameLen = nameLen;
+	segment->hash = json_internHash(name, nameLen);
+	segment->index = 0;
+}
+
+/* read a name, up to one of the characters in 'stop' (or the end) */
+static json_err json_queryName(struct json_queryParser *p, const char *stop, struct json_pathSegment *segment) {
+	unsigned char *start, *end;
+
+	start = p->t;
+	json_querySkip(start);
+	for (end = start; *end != '\0' && !strchr(stop, *end); end++);
+	p->t = end;
+
+	while (end > start && end[-1] == ' ') end--;
+	if (end == start) return JSON_EINVAL;
+
+	json_queryNameSegment(segment, start, end - start);
+
+	return JSON_ENONE;
+}
+
+/* read a 'quoted' or "quoted" string. there are no escapes */
+static json_err json_queryQuoted(struct json_queryParser *p, unsigned char **str, unsigned int *len) {
+	unsigned char *end;
+
+	if ((end = (unsigned char *)strchr((char *)&(p->t[1]), p->t[0])) == NULL) return JSON_EINVAL;
+	*str = &(p->t[1]);
+	*len = end - *str;
+	p->t = &(end[1]);
+
+	return JSON_ENONE;
+}
+
+static json_err json_queryIndex(struct json_queryParser *p, struct json_pathSegment *segment) {
+	unsigned int index;
+
+	for (index = 0; isdigit(*p->t); p->t++) {
+		if (index > (UINT_MAX - (*p->t - '0')) / 10) return JSON_EINVAL;
+		index = (index * 10) + (*p->t - '0');
+	}
+
+	segment->name = NULL;
+	segment->nameLen = 0;
+	segment->hash = 0;
+	segment->index = index;
+
+	return JSON_ENONE;
+}
+
+/* the inside of [...] - a number, a quoted name, or "*" */
+static json_err json_queryBracket(struct json_queryParser *p, struct json_pathSegment *segment, int *wildcard) {
+	json_err ret;
+	unsigned char *name;
+	unsigned int nameLen;
+
+	json_querySkip(p->t);
+	if (*p->t == '*' && wildcard) {
+		*wildcard = 1;
+		p->t++;
+	} else if (isdigit(*p->t)) {
+		if ((ret = json_queryIndex(p, segment)) != JSON_ENONE) return ret;
+	} else if (*p->t == '\'' || *p->t == '"') {
+		if ((ret = json_queryQuoted(p, &name, &nameLen)) != JSON_ENONE) return ret;
+		json_queryNameSegment(segment, name, nameLen);
+	} else {
+		return JSON_EINVAL;
+	}
+	json_querySkip(p->t);
+
+	if (*p->t != ']') return JSON_EINVAL;
+	p->t++;
+
+	return JSON_ENONE;
+}
+
+static json_err json_queryLiteral(struct json_queryParser *p, struct json_queryValue *value) {
+	json_err ret;
+	unsigned char *end;
+
+	if (*p->t == '\'' || *p->t == '"') {
+		value->type = JSON_STRING;
+		return json_queryQuoted(p, &value->string, &value->stringLen);
+	}
+	if (!strncmp((char *)p->t, "true", 4) || !strncmp((char *)p->t, "false", 5)) {
+		value->type = JSON_BOOLEAN;
+		value->boolean = (*p->t == 't');
+		p->t += value->boolean ? 4 : 5;
+		return JSON_ENONE;
+	}
+	if (!strncmp((char *)p->t, "null", 4)) {
+		value->type = JSON_NULL;
+		p->t += 4;
+		return JSON_ENONE;
+	}
+
+	for (end = p->t; *end != '\0' && strchr("+-0123456789.eE", *end); end++);
+	if ((ret = json_numberParse(p->t, end - p->t, &value->number)) != JSON_ENONE) return ret;
+	value->type = value->number.type;
+	p->t = end;
+
+	return JSON_ENONE;
+}
+
+/* the inside of [?(...)] - '@', a path from there, and then maybe a comparison */
+static json_err json_queryFilter(struct json_queryParser *p, struct json_queryStep *step) {
+	json_err ret;
+	struct json_pathSegment *segment;
+	static const struct {
+		const char *str;
+		enum json_queryOp op;
+	} ops[] = {
+		{ "==", QUERY_EQ }, { "!=", QUERY_NE }, { "<=", QUERY_LE }, { ">=", QUERY_GE },
+		{ "<", QUERY_LT }, { ">", QUERY_GT }, { NULL, QUERY_EXISTS },
+	};
+	unsigned int i;
+
+	json_querySkip(p->t);
+	if (*p->t != '(') return JSON_EINVAL;
+	p->t++;
+	json_querySkip(p->t);
+	if (*p->t != '@') return JSON_EINVAL;
+	p->t++;
+
+	step->first = p->segments;
+	for (step->count = 0;; step->count++) {
+		segment = p->query->segments ? &(p->query->segments[p->segments]) : &p->spareSegment;
+		if (*p->t == '.') {
+			p->t++;
+			if ((ret = json_queryName(p, " .[]()=!<>", segment)) != JSON_ENONE) return ret;
+		} else if (*p->t == '[') {
+			p->t++;
+			if ((ret = json_queryBracket(p, segment, NULL)) != JSON_ENONE) return ret;
+		} else {
+			break;
+		}
+		p->segments++;
+	}
+	json_querySkip(p->t);
+
+	step->op = QUERY_EXISTS;
+	for (i = 0; ops[i].str; i++) {
+		if (strncmp((char *)p->t, ops[i].str, strlen(ops[i].str))) continue;
+		step->op = ops[i].op;
+		p->t += strlen(ops[i].str);
+		json_querySkip(p->t);
+		if ((ret = json_queryLiteral(p, &step->value)) != JSON_ENONE) return ret;
+		json_querySkip(p->t);
+		break;
+	}
+
+	if (*p->t != ')') return JSON_EINVAL;
+	p->t++;
+
+	return JSON_ENONE;
+}
+
+static json_err json_queryParse(struct json_queryParser *p) {
+	json_err ret;
+	struct json_queryStep *step;
+	int wildcard;
+
+	json_querySkip(p->t);
+	if (*p->t == '$') p->t++;
+
+	for (;;) {
+		json_querySkip(p->t);
+		if (*p->t == '\0') break;
+
+		step = p->query->steps ? &(p->query->steps[p->steps]) : &p->spareStep;
+		memset(step, 0, sizeof(*step));
+
+		if (p->t[0] == '.' && p->t[1] == '.') {
+			step->recursive = 1;
+			p->t += 2;
+		} else if (*p->t == '.') {
+			p->t++;
+		} else if (*p->t != '[' && p->steps > 0) {
+			/* only the first name can go without a dot */
+			return JSON_EINVAL;
+		}
+		json_querySkip(p->t);
+
+		if (*p->t == '*') {
+			step->type = QUERY_WILDCARD;
+			p->t++;
+		} else if (p->t[0] == '[' && p->t[1] == '?') {
+			step->type = QUERY_FILTER;
+			p->t += 2;
+			if ((ret = json_queryFilter(p, step)) != JSON_ENONE) return ret;
+			json_querySkip(p->t);
+			if (*p->t != ']') return JSON_EINVAL;
+			p->t++;
+		} else if (*p->t == '[') {
+			p->t++;
+			wildcard = 0;
+			if ((ret = json_queryBracket(p, &step->segment, &wildcard)) != JSON_ENONE) return ret;
+			step->type = wildcard ? QUERY_WILDCARD : (step->segment.name ? QUERY_NAME : QUERY_INDEX);
+		} else {
+			step->type = QUERY_NAME;
+			if ((ret = json_queryName(p, ".[", &step->segment)) != JSON_ENONE) return ret;
+		}
+
+		p->steps++;
+	}
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_queryCompile(const unsigned char *str, struct json_query **queryRet) {
+	json_err ret;
+	struct json_queryParser p;
+	struct json_query counting, *query;
+	unsigned char *copy;
+	size_t len;
+
+	if (!str || !queryRet) return JSON_EMISSINGPARAM;
+
+	/* count everything first, so that the whole thing can be one allocation */
+	memset(&p, 0, sizeof(p));
+	p.t = (unsigned char *)str;
+	memset(&counting, 0, sizeof(counting));
+	p.query = &counting;
+	if ((ret = json_queryParse(&p)) != JSON_ENONE) return ret;
+
+	len = strlen((char *)str);
+	if ((query = json_alloc(NULL, sizeof(*query) + (sizeof(*query->steps) * p.steps) + (sizeof(*query->segments) * p.segments) + len + 1)) == NULL) return JSON_ENOMEM;
+	memset(query, 0, sizeof(*query));
+	query->count = p.steps;
+	query->steps = (struct json_queryStep *)&(query[1]);
+	query->segmentCount = p.segments;
+	query->segments = (struct json_pathSegment *)&(query->steps[query->count]);
+
+	/* the names and strings point into our own copy, rather than the caller's */
+	copy = (unsigned char *)&(query->segments[query->segmentCount]);
+	memcpy(copy, str, len + 1);
+	memset(&p, 0, sizeof(p));
+	p.t = copy;
+	p.query = query;
+	json_queryParse(&p);
+
+	*queryRet = query;
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_queryFree(struct json_query *query) {
+	if (!query) return JSON_EMISSINGPARAM;
+	json_free(NULL, query);
+	return JSON_ENONE;
+}
+
+/* -1, 0 or 1, as 'a' is less than, equal to or more than 'b' */
+static int json_queryCompareNumbers(struct json_number *a, struct json_number *b) {
+	double x, y;
+
+	if (a->type == JSON_INTEGER && b->type == JSON_INTEGER) {
+		if (a->isUnsigned && b->isUnsigned) return (a->data.asUInt64 > b->data.asUInt64) - (a->data.asUInt64 < b->data.asUInt64);
+		/* an unsigned one is above INT64_MAX, so it's bigger than any signed one */
+		if (a->isUnsigned) return 1;
+		if (b->isUnsigned) return -1;
+		return (a->data.asInt64 > b->data.asInt64) - (a->data.asInt64 < b->data.asInt64);
+	}
+
+	x = (a->type == JSON_FLOAT) ? a->data.asFloat : a->isUnsigned ? (double)a->data.asUInt64 : (double)a->data.asInt64;
+	y = (b->type == JSON_FLOAT) ? b->data.asFloat : b->isUnsigned ? (double)b->data.asUInt64 : (double)b->data.asInt64;
+
+	return (x > y) - (x < y);
+}
+
+/* does 'element' get through the filter? */
+static json_err json_queryTest(struct json_query *query, struct json_queryStep *step, struct json_element *element, int *pass) {
+	json_err ret;
+	struct json_pathSegment *segment;
+	struct json_queryValue *value;
+	struct json_number number;
+	unsigned int i, len;
+	int c;
+
+	*pass = 0;
+
+	for (i = 0; i < step->count; i++) {
+		segment = &(query->segments[step->first + i]);
+		if (element->type != (segment->name ? JSON_OBJECT : JSON_ARRAY)) return JSON_ENONE;
+		ret = json_pathStep(element, segment, &element);
+		if (ret == JSON_EMISSING) return JSON_ENONE;
+		if (ret != JSON_ENONE) return ret;
+	}
+
+	if (step->op == QUERY_EXISTS) {
+		*pass = 1;
+		return JSON_ENONE;
+	}
+
+	/* anything of a different type isn't equal, and isn't more or less either */
+	value = &step->value;
+	switch (value->type) {
+		case JSON_STRING:
+			if (element->type != JSON_STRING) goto different;
+			len = (element->data_len < value->stringLen) ? element->data_len : value->stringLen;
+			if ((c = memcmp(json_elementString(element), value->string, len)) == 0) {
+				c = (element->data_len > value->stringLen) - (element->data_len < value->stringLen);
+			}
+			break;
+
+		case JSON_INTEGER:
+		case JSON_FLOAT:
+			if (element->type == JSON_INTEGER) {
+				number.type = JSON_INTEGER;
+				number.isUnsigned = !!(element->flags & ELEMENT_UNSIGNED);
+				number.data.asInt64 = element->data.asInt64;
+			} else if (element->type == JSON_FLOAT) {
+				number.type = JSON_FLOAT;
+				number.isUnsigned = 0;
+				number.data.asFloat = element->data.asFloat;
+			} else {
+				goto different;
+			}
+			c = json_queryCompareNumbers(&number, &value->number);
+			break;
+
+		case JSON_BOOLEAN:
+			if (element->type != JSON_BOOLEAN) goto different;
+			c = !!element->data.asInt - value->boolean;
+			break;
+
+		case JSON_NULL:
+			if (element->type != JSON_NULL) goto different;
+			c = 0;
+			break;
+
+		default:
+			goto different;
+	}
+
+	switch (step->op) {
+		case QUERY_EQ: *pass = (c == 0); break;
+		case QUERY_NE: *pass = (c != 0); break;
+		case QUERY_LT: *pass = (c < 0);  break;
+		case QUERY_LE: *pass = (c <= 0); break;
+		case QUERY_GT: *pass = (c > 0);  break;
+		case QUERY_GE: *pass = (c >= 0); break;
+		default: break;
+	}
+
+	return JSON_ENONE;
+
+different:
+	*pass = (step->op == QUERY_NE);
+	return JSON_ENONE;
+}
+
+static json_err json_queryMatch(struct json_queryRunner *r, unsigned int step, struct json_element *element);
+
+/* take one step down from 'element', and carry on from wherever it leads */
+static json_err json_queryStep(struct json_queryRunner *r, unsigned int step, struct json_element *element) {
+	json_err ret;
+	struct json_queryStep *s;
+	struct json_element *child;
+	int pass;
+
+	s = &(r->query->steps[step]);
+	switch (s->type) {
+		case QUERY_NAME:
+		case QUERY_INDEX:
+			if (element->type != ((s->type == QUERY_NAME) ? JSON_OBJECT : JSON_ARRAY)) return JSON_ENONE;
+			ret = json_pathStep(element, &s->segment, &child);
+			if (ret == JSON_EMISSING) return JSON_ENONE;
+			if (ret != JSON_ENONE) return ret;
+			return json_queryMatch(r, step + 1, child);
+
+		case QUERY_WILDCARD:
+		case QUERY_FILTER:
+			if ((ret = json_parseExpand(element)) != JSON_ENONE) return ret;
+			for (child = element->child_head; child; child = child->sibling_next) {
+				if (s->type == QUERY_FILTER) {
+					if ((ret = json_queryTest(r->query, s, child, &pass)) != JSON_ENONE) return ret;
+					if (!pass) continue;
+				}
+				if ((ret = json_queryMatch(r, step + 1, child)) != JSON_ENONE) return ret;
+			}
+			return JSON_ENONE;
+	}
+
+	return JSON_EINVAL;
+}
+
+static json_err json_queryMatch(struct json_queryRunner *r, unsigned int step, struct json_element *element) {
+	json_err ret;
+	struct json_element *e;
+
+	if (step == r->query->count) return r->onMatch(r->ctx, element);
+	if (!r->query->steps[step].recursive) return json_queryStep(r, step, element);
+
+	/* '..' - take the step from here, and from everything under here. this walks the tree
+	   rather than recursing, as recursing down a deep document would run out of stack */
+	for (e = element;;) {
+		if ((ret = json_queryStep(r, step, e)) != JSON_ENONE) return ret;
+		if ((ret = json_parseExpand(e)) != JSON_ENONE) return ret;
+		if (e->child_head) {
+			e = e->child_head;
+			continue;
+		}
+		while (e != element && !e->sibling_next) e = e->parent;
+		if (e == element) break;
+		e = e->sibling_next;
+	}
+
+	return JSON_ENONE;
+}
+
+EXPORT json_err json_queryRun(struct json_element *root, struct json_query *query, json_err (*onMatch)(void *ctx, struct json_element *element), void *ctx) {
+	struct json_queryRunner r;
+
+	if (!root || !query || !onMatch) return JSON_EMISSINGPARAM;
+
+	r.query = query;
+	r.onMatch = onMatch;
+	r.ctx = ctx;
+
+	return json_queryMatch(&r, 0, root);
+}
@@ -0,0 +1,72 @@
+#ifndef __QUERY_H
+#define __QUERY_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "number.h"
+#include "path.h"
+
+enum json_queryStepType {
+	QUERY_NAME,     /* .name or ['name'] */
+	QUERY_INDEX,    /* [n] */
+	QUERY_WILDCARD, /* .* or [*] */
+	QUERY_FILTER,   /* [?(@.a.b == "c")] */
+};
+
+enum json_queryOp {
+	QUERY_EXISTS, /* no comparison, the path just has to be there */
+	QUERY_EQ,
+	QUERY_NE,
+	QUERY_LT,
+	QUERY_LE,
+	QUERY_GT,
+	QUERY_GE,
+};
+
+/* the literal on the right hand side of a filter */
+struct json_queryValue {
+	enum json_dataTypes type; /* JSON_STRING, JSON_INTEGER, JSON_FLOAT, JSON_BOOLEAN or JSON_NULL */
+	struct json_number number;
+	unsigned char *string;
+	unsigned int stringLen;
+	int boolean;
+};
+
+struct json_queryStep {
+	enum json_queryStepType type;
+	int recursive; /* '..' - apply the step at every level below, as well as here */
+	struct json_pathSegment segment; /* QUERY_NAME and QUERY_INDEX */
+	/* QUERY_FILTER - follow 'count' of the query's segments from 'first', and then compare */
+	unsigned int first;
+	unsigned int count;
+	enum json_queryOp op;
+	struct json_queryValue value;
+};
+
+/* the steps, the filters' segments, and a copy of the query (that the names and strings
+   point into) all follow on in the same allocation */
+struct json_query {
+	unsigned int count;
+	struct json_queryStep *steps;
+	unsigned int segmentCount;
+	struct json_pathSegment *segments;
+};
+
+#endif /* __QUERY_H */
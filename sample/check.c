@@ -0,0 +1,591 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* checks that the different ways of getting a document in (and of looking around it) agree
+   with each other. run with 'make test' - every failure is reported, and the exit status is
+   the number of them */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdarg.h>
+
+#include <json.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+			fprintf(stderr, __VA_ARGS__); \
+			fprintf(stderr, "\n"); \
+			failures++; \
+		} \
+	} while (0)
+
+/* somewhere for the documents that are put together below */
+struct text {
+	char *data;
+	unsigned int len;
+	unsigned int size;
+};
+
+static void textAdd(struct text *t, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void textAdd(struct text *t, const char *fmt, ...) {
+	va_list ap;
+	int n;
+
+	for (;;) {
+		va_start(ap, fmt);
+		n = vsnprintf(t->data + t->len, t->size - t->len, fmt, ap);
+		va_end(ap);
+		if (n >= 0 && (unsigned int)n < t->size - t->len) break;
+		t->size = (t->size ? t->size * 2 : 4096) + n;
+		if ((t->data = realloc(t->data, t->size)) == NULL) {
+			perror("realloc()");
+			exit(1);
+		}
+	}
+	t->len += n;
+}
+
+static unsigned char *readFile(const char *path, unsigned int *len) {
+	FILE *f;
+	unsigned char *data;
+	long n;
+
+	if ((f = fopen(path, "rb")) == NULL) {
+		perror(path);
+		exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	n = ftell(f);
+	rewind(f);
+	if ((data = malloc(n + 1)) == NULL || fread(data, 1, n, f) != (size_t)n) {
+		perror(path);
+		exit(1);
+	}
+	fclose(f);
+	data[n] = '\0';
+	*len = n;
+
+	return data;
+}
+
+/* give 'data' to the document 'chunk' bytes at a time (or all at once, if 'chunk' is 0) */
+static json_err feed(struct json *json, const unsigned char *data, unsigned int len, unsigned int chunk) {
+	json_err ret;
+	unsigned int i, n;
+
+	if (chunk == 0) chunk = len;
+	for (i = 0, ret = JSON_EINCOMPLETE; i < len; i += n) {
+		n = (len - i < chunk) ? len - i : chunk;
+		ret = json_dataAdd(json, &(data[i]), n);
+		if (ret != JSON_ENONE && ret != JSON_EINCOMPLETE) break;
+	}
+
+	return ret;
+}
+
+/* parse 'data' a chunk at a time (see feed()), and print it */
+static json_err parseChunked(const unsigned char *data, unsigned int len, unsigned int chunk, unsigned char **out) {
+	json_err ret;
+	struct json *json;
+	unsigned int outLen;
+
+	if ((ret = json_new(&json, NULL)) != JSON_ENONE) return ret;
+	if ((ret = feed(json, data, len, chunk)) == JSON_ECOMPLETE) ret = json_print(json, out, &outLen);
+	json_destroy(json);
+
+	return ret;
+}
+
+/* a document with a bit of everything in it */
+static const char *tricky =
+	"{ \"name\" : \"escapes \\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u00e9 \\ud83d\\ude00 and \\u0041 plain text that goes on a bit\",\n"
+	"  \"numbers\": [0, -1, 1.5, -2.25e-3, 1E10, 9223372036854775807, -9223372036854775808, 18446744073709551615],\n"
+	"  \"flags\": [true, false, null],\n"
+	"  \"deep\": {\"a\": {\"b\": {\"c\": [[[{\"d\": \"}]{[,:\"}]]]}}},\n"
+	"  \"empty\": {\"o\": {}, \"a\": [], \"s\": \"\"},\n"
+	"  \"short\": \"hi\"\n"
+	"}";
+
+/* the same output whatever size the pieces are that it arrives in */
+static void checkChunked(void) {
+	const unsigned int chunks[] = { 1, 2, 3, 7, 64, 4096 };
+	const char *files[] = { "./testdata.json", NULL };
+	unsigned char *docs[2], *ref, *out, *copy;
+	unsigned int lens[2], d, i, outLen;
+	struct json *json;
+	json_err ret;
+
+	docs[0] = readFile(files[0], &lens[0]);
+	docs[1] = (unsigned char *)strdup(tricky);
+	lens[1] = strlen(tricky);
+
+	for (d = 0; d < 2; d++) {
+		ret = parseChunked(docs[d], lens[d], 0, &ref);
+		CHECK(ret == JSON_ENONE, "document %u: one-shot parse failed: %d", d, ret);
+		if (ret != JSON_ENONE) continue;
+
+		for (i = 0; i < sizeof(chunks) / sizeof(*chunks); i++) {
+			ret = parseChunked(docs[d], lens[d], chunks[i], &out);
+			CHECK(ret == JSON_ENONE, "document %u: %u byte chunks failed: %d", d, chunks[i], ret);
+			if (ret != JSON_ENONE) continue;
+			CHECK(!strcmp((char *)out, (char *)ref), "document %u: %u byte chunks differ:\n%s\n%s", d, chunks[i], out, ref);
+			free(out);
+		}
+
+		/* in place, where the escapes are decoded over the top of the input */
+		copy = (unsigned char *)strdup((char *)docs[d]);
+		json_new(&json, NULL);
+		ret = json_dataBorrow(json, copy, lens[d]);
+		CHECK(ret == JSON_ECOMPLETE, "document %u: json_dataBorrow() failed: %d", d, ret);
+		if (ret == JSON_ECOMPLETE && json_print(json, &out, &outLen) == JSON_ENONE) {
+			CHECK(!strcmp((char *)out, (char *)ref), "document %u: json_dataBorrow() differs", d);
+			free(out);
+		}
+		json_destroy(json);
+		free(copy);
+
+		if (files[d]) {
+			json_new(&json, NULL);
+			ret = json_parseFile(json, files[d]);
+			CHECK(ret == JSON_ECOMPLETE, "json_parseFile(%s) failed: %d", files[d], ret);
+			if (ret == JSON_ECOMPLETE && json_print(json, &out, &outLen) == JSON_ENONE) {
+				CHECK(!strcmp((char *)out, (char *)ref), "json_parseFile(%s) differs", files[d]);
+				free(out);
+			}
+			json_destroy(json);
+		}
+
+		free(ref);
+		free(docs[d]);
+	}
+}
+
+static void checkEscapes(void) {
+	const char *bad[] = {
+		"{\"s\":\"\\q\"}",          /* not an escape */
+		"{\"s\":\"\\u12G4\"}",      /* not hex */
+		"{\"s\":\"\\u12\"}",        /* too short */
+		"{\"s\":\"\\ud800\"}",      /* half of a surrogate pair */
+		"{\"s\":\"\\udc00x\"}",     /* the wrong half */
+		NULL
+	};
+	const unsigned char want[] = "a\"b\\c/d\n\t\xc3\xa9\xf0\x9f\x98\x80";
+	const char *good = "{\"s\":\"a\\\"b\\\\c\\/d\\n\\t\\u00e9\\ud83d\\ude00\"}";
+	struct json *json;
+	struct json_element *root;
+	unsigned char *s, *out;
+	unsigned int i, sLen;
+	json_err ret;
+
+	/* the error has to come out whichever piece the bad escape arrives in */
+	for (i = 0; bad[i]; i++) {
+		ret = parseChunked((const unsigned char *)bad[i], strlen(bad[i]), 0, &out);
+		CHECK(ret == JSON_EINVAL, "%s: expected JSON_EINVAL, got %d", bad[i], ret);
+		if (ret == JSON_ENONE) free(out);
+		ret = parseChunked((const unsigned char *)bad[i], strlen(bad[i]), 1, &out);
+		CHECK(ret == JSON_EINVAL, "%s: byte by byte, expected JSON_EINVAL, got %d", bad[i], ret);
+		if (ret == JSON_ENONE) free(out);
+	}
+
+	json_new(&json, &root);
+	ret = json_dataAdd(json, (const unsigned char *)good, strlen(good));
+	CHECK(ret == JSON_ECOMPLETE, "%s: failed: %d", good, ret);
+	ret = json_getString(root, (unsigned char *)"s", &s, &sLen);
+	CHECK(ret == JSON_ENONE && sLen == sizeof(want) - 1 && !memcmp(s, want, sLen), "%s: decoded wrongly", good);
+	json_destroy(json);
+}
+
+static void checkNumbers(void) {
+	const char *doc = "{\"max\":9223372036854775807,\"min\":-9223372036854775808,\"umax\":18446744073709551615,\"int\":2147483648,\"big\":18446744073709551616}";
+	const char *huge[] = { "{\"n\":1e400}", "{\"n\":-1e400}", NULL };
+	struct json *json;
+	struct json_element *root;
+	unsigned char *out;
+	unsigned int i, outLen;
+	int64_t i64;
+	uint64_t u64;
+	double f;
+	int n;
+	json_err ret;
+
+	json_new(&json, &root);
+	ret = json_dataAdd(json, (const unsigned char *)doc, strlen(doc));
+	CHECK(ret == JSON_ECOMPLETE, "numbers: failed: %d", ret);
+
+	ret = json_getInteger64(root, (unsigned char *)"max", &i64);
+	CHECK(ret == JSON_ENONE && i64 == INT64_MAX, "max: %d %" PRId64, ret, i64);
+	ret = json_getInteger64(root, (unsigned char *)"min", &i64);
+	CHECK(ret == JSON_ENONE && i64 == INT64_MIN, "min: %d %" PRId64, ret, i64);
+	ret = json_getUInteger64(root, (unsigned char *)"umax", &u64);
+	CHECK(ret == JSON_ENONE && u64 == UINT64_MAX, "umax: %d %" PRIu64, ret, u64);
+	ret = json_getUInteger64(root, (unsigned char *)"max", &u64);
+	CHECK(ret == JSON_ENONE && u64 == INT64_MAX, "max as unsigned: %d %" PRIu64, ret, u64);
+
+	/* there, but too big for what was asked for */
+	CHECK(json_getInteger64(root, (unsigned char *)"umax", &i64) == JSON_ERANGE, "umax as signed");
+	CHECK(json_getUInteger64(root, (unsigned char *)"min", &u64) == JSON_ERANGE, "min as unsigned");
+	CHECK(json_getInteger(root, (unsigned char *)"int", &n) == JSON_ERANGE, "int as an int");
+
+	/* too big for any integer, so it's kept as a double */
+	ret = json_getFloat(root, (unsigned char *)"big", &f);
+	CHECK(ret == JSON_ENONE && f == 18446744073709551616.0, "big: %d %f", ret, f);
+
+	ret = json_print(json, &out, &outLen);
+	CHECK(ret == JSON_ENONE && strstr((char *)out, "\"max\":9223372036854775807,\"min\":-9223372036854775808,\"umax\":18446744073709551615,\"int\":2147483648"), "numbers don't print back: %s", out);
+	if (ret == JSON_ENONE) free(out);
+	json_destroy(json);
+
+	for (i = 0; huge[i]; i++) {
+		ret = parseChunked((const unsigned char *)huge[i], strlen(huge[i]), 0, &out);
+		CHECK(ret == JSON_ERANGE, "%s: expected JSON_ERANGE, got %d", huge[i], ret);
+		if (ret == JSON_ENONE) free(out);
+	}
+}
+
+struct streamState {
+	struct text out;
+	unsigned int count;
+};
+
+static json_err onDocument(void *ctx, struct json_element *root) {
+	struct streamState *state = ctx;
+	unsigned char *out;
+	unsigned int outLen;
+	json_err ret;
+
+	if ((ret = json_printElement(root, &out, &outLen)) != JSON_ENONE) return ret;
+	textAdd(&state->out, "%s\n", out);
+	free(out);
+	state->count++;
+
+	return JSON_ENONE;
+}
+
+/* several documents one after another, each of which should come out as it would on its own */
+static void checkStream(const unsigned char *data) {
+	const unsigned int chunks[] = { 0, 1, 5, 100 };
+	const char *docs[] = { "{\"a\":1}", "{\"b\":[1,2,{\"c\":\"d\"}]}", tricky, "{}", (const char *)data, "{\"last\":true}", NULL };
+	struct text stream, ref;
+	struct streamState state;
+	struct json *json;
+	unsigned char *out;
+	unsigned int c, want;
+	json_err ret;
+
+	memset(&stream, 0, sizeof(stream));
+	memset(&ref, 0, sizeof(ref));
+	for (want = 0; docs[want]; want++) {
+		textAdd(&stream, "%s\n", docs[want]);
+		ret = parseChunked((const unsigned char *)docs[want], strlen(docs[want]), 0, &out);
+		CHECK(ret == JSON_ENONE, "stream document %u: failed on its own: %d", want, ret);
+		if (ret != JSON_ENONE) continue;
+		textAdd(&ref, "%s\n", out);
+		free(out);
+	}
+
+	for (c = 0; c < sizeof(chunks) / sizeof(*chunks); c++) {
+		memset(&state, 0, sizeof(state));
+		json_new(&json, NULL);
+		json_setDocumentCallback(json, onDocument, &state);
+		ret = feed(json, (unsigned char *)stream.data, stream.len, chunks[c]);
+		CHECK(ret == JSON_EINCOMPLETE || ret == JSON_ENONE, "stream in %u byte chunks: %d", chunks[c], ret);
+		CHECK(state.count == want, "stream in %u byte chunks: %u documents, not %u", chunks[c], state.count, want);
+		CHECK(state.out.len == ref.len && !memcmp(state.out.data, ref.data, ref.len), "stream in %u byte chunks: documents differ", chunks[c]);
+		json_destroy(json);
+		free(state.out.data);
+	}
+
+	free(stream.data);
+	free(ref.data);
+}
+
+/* a lazy document should look just the same from the outside */
+static void checkLazy(const unsigned char *data, unsigned int len) {
+	const char *docs[] = { (const char *)data, tricky, NULL };
+	const unsigned int chunks[] = { 0, 1, 64 };
+	struct json *json;
+	struct json_element *root;
+	unsigned char *ref, *out, *s;
+	unsigned int c, d, outLen, sLen;
+	double f;
+	json_err ret;
+
+	for (d = 0; docs[d]; d++) {
+		len = strlen(docs[d]);
+		if ((ret = parseChunked((const unsigned char *)docs[d], len, 0, &ref)) != JSON_ENONE) continue;
+
+		for (c = 0; c < sizeof(chunks) / sizeof(*chunks); c++) {
+			json_new(&json, &root);
+			json_setLazy(json, 1);
+			ret = feed(json, (const unsigned char *)docs[d], len, chunks[c]);
+			CHECK(ret == JSON_ECOMPLETE, "lazy document %u in %u byte chunks: %d", d, chunks[c], ret);
+
+			/* look inside something first, so that only part of it has been expanded */
+			if (d == 0) {
+				ret = json_getFloat(root, (unsigned char *)"results[1].location.lat", &f);
+				CHECK(ret == JSON_ENONE && f == 36.462787, "lazy results[1].location.lat: %d %f", ret, f);
+			} else {
+				ret = json_getString(root, (unsigned char *)"deep.a.b.c[0][0][0].d", &s, &sLen);
+				CHECK(ret == JSON_ENONE && sLen == 6 && !memcmp(s, "}]{[,:", 6), "lazy deep.a.b.c[0][0][0].d: %d", ret);
+			}
+
+			ret = json_print(json, &out, &outLen);
+			CHECK(ret == JSON_ENONE && !strcmp((char *)out, (char *)ref), "lazy document %u in %u byte chunks differs", d, chunks[c]);
+			if (ret == JSON_ENONE) free(out);
+			json_destroy(json);
+		}
+		free(ref);
+	}
+}
+
+/* only what was asked for (and its parents) is kept, and it has the same value as in the full document */
+static void checkProjection(const unsigned char *data, unsigned int len) {
+	unsigned char *paths[] = { (unsigned char *)"results[1].location.lat", (unsigned char *)"status", NULL };
+	unsigned char *badPaths[] = { (unsigned char *)"results[99999999999]", NULL };
+	const unsigned int chunks[] = { 0, 1, 64 };
+	struct json *json;
+	struct json_element *root;
+	unsigned char *out, *s, *refStatus;
+	unsigned int c, outLen, sLen, refStatusLen;
+	double f, refLat;
+	json_err ret;
+
+	json_new(&json, &root);
+	json_dataAdd(json, data, len);
+	ret = json_getFloat(root, (unsigned char *)"results[1].location.lat", &refLat);
+	CHECK(ret == JSON_ENONE, "results[1].location.lat: %d", ret);
+	ret = json_getString(root, (unsigned char *)"status", &s, &sLen);
+	CHECK(ret == JSON_ENONE, "status: %d", ret);
+	refStatus = (unsigned char *)strndup((char *)s, sLen);
+	refStatusLen = sLen;
+	json_destroy(json);
+
+	for (c = 0; c < sizeof(chunks) / sizeof(*chunks); c++) {
+		json_new(&json, &root);
+		ret = json_setProjection(json, paths);
+		CHECK(ret == JSON_ENONE, "json_setProjection(): %d", ret);
+		ret = feed(json, data, len, chunks[c]);
+		CHECK(ret == JSON_ECOMPLETE, "projection in %u byte chunks: %d", chunks[c], ret);
+
+		/* the array loses the members before the one that was wanted */
+		ret = json_getFloat(root, (unsigned char *)"results[0].location.lat", &f);
+		CHECK(ret == JSON_ENONE && f == refLat, "projected lat: %d %f", ret, f);
+		ret = json_getString(root, (unsigned char *)"status", &s, &sLen);
+		CHECK(ret == JSON_ENONE && sLen == refStatusLen && !memcmp(s, refStatus, sLen), "projected status: %d", ret);
+
+		ret = json_print(json, &out, &outLen);
+		CHECK(ret == JSON_ENONE && !strcmp((char *)out, "{\"results\":[{\"location\":{\"lat\":36.462787000000}}],\"status\":\"OK\"}"), "projection in %u byte chunks: %s", chunks[c], out);
+		if (ret == JSON_ENONE) free(out);
+		json_destroy(json);
+	}
+
+	json_new(&json, NULL);
+	ret = json_setProjection(json, badPaths);
+	CHECK(ret == JSON_EINVAL, "an index that doesn't fit: %d", ret);
+	json_destroy(json);
+
+	free(refStatus);
+}
+
+/* a big array, which json_dataParallel() splits up. whatever the number of threads (and
+   whatever the document's settings), the result has to be the same */
+static void checkParallel(void) {
+	const unsigned int threads[] = { 2, 3, 4, 8, 0 };
+	struct text doc;
+	struct json *json;
+	struct json_element *root;
+	unsigned char *ref, *out, *s;
+	unsigned int i, t, outLen, sLen;
+	int n;
+	json_err ret;
+
+	memset(&doc, 0, sizeof(doc));
+	textAdd(&doc, "[");
+	for (i = 0; i < 20000; i++) {
+		textAdd(&doc, "%s{\"id\":%u,\"name\":\"item \\\"%u\\\" \\u00e9\",\"tags\":[\"a\",\"b]},{\"],\"score\":%u.%u,\"ok\":%s,\"big\":%" PRIu64 "}",
+		        i ? ",\n" : "", i, i, i % 100, i % 7, (i & 1) ? "true" : "false", UINT64_MAX - i);
+	}
+	textAdd(&doc, "]");
+
+	/* one thread is the same as json_dataAdd() */
+	json_new(&json, &root);
+	json_setIndexWidth(json, 4);
+	ret = json_dataParallel(json, (unsigned char *)doc.data, doc.len, 1);
+	CHECK(ret == JSON_ECOMPLETE, "serial: %d", ret);
+	ret = json_print(json, &ref, &outLen);
+	CHECK(ret == JSON_ENONE, "serial print: %d", ret);
+	json_destroy(json);
+	if (ret != JSON_ENONE) return;
+
+	for (t = 0; t < sizeof(threads) / sizeof(*threads); t++) {
+		json_new(&json, &root);
+		json_setIndexWidth(json, 4);
+		json_setBufferGrowth(json, 25);
+		ret = json_dataParallel(json, (unsigned char *)doc.data, doc.len, threads[t]);
+		CHECK(ret == JSON_ECOMPLETE, "%u threads: %d", threads[t], ret);
+
+		ret = json_getInteger(root, (unsigned char *)"[12345].id", &n);
+		CHECK(ret == JSON_ENONE && n == 12345, "%u threads: [12345].id: %d %d", threads[t], ret, n);
+		ret = json_getString(root, (unsigned char *)"[19999].name", &s, &sLen);
+		CHECK(ret == JSON_ENONE && !strcmp((char *)s, "item \"19999\" \xc3\xa9"), "%u threads: [19999].name: %d", threads[t], ret);
+
+		ret = json_print(json, &out, &outLen);
+		CHECK(ret == JSON_ENONE && !strcmp((char *)out, (char *)ref), "%u threads: differs from serial", threads[t]);
+		if (ret == JSON_ENONE) free(out);
+		json_destroy(json);
+	}
+
+	free(ref);
+	free(doc.data);
+}
+
+/* objects and arrays get an index once they are wide enough - it has to stay right as
+   children come and go */
+static void checkIndexes(void) {
+	struct json *json;
+	struct json_element *root, *arr, *child, *obj;
+	char name[32];
+	int present[300], values[400], count, i, j, n;
+	enum json_dataTypes type;
+	unsigned int len;
+	json_err ret;
+
+	json_new(&json, &root);
+	json_setIndexWidth(json, 4);
+
+	/* an object, by name */
+	json_addObject(root, (unsigned char *)"", (unsigned char *)"o", &obj);
+	for (i = 0; i < 200; i++) {
+		sprintf(name, "k%d", i);
+		json_addInteger(root, (unsigned char *)"o", (unsigned char *)name, i);
+		present[i] = 1;
+	}
+	for (i = 0; i < 300; i++) {
+		sprintf(name, "o.k%d", i);
+		if (i % 3 == 0 && i < 200) {
+			ret = json_deleteElement(root, (unsigned char *)name);
+			CHECK(ret == JSON_ENONE, "delete %s: %d", name, ret);
+			present[i] = 0;
+		}
+	}
+	for (i = 200; i < 300; i++) {
+		sprintf(name, "k%d", i);
+		json_addInteger(root, (unsigned char *)"o", (unsigned char *)name, i);
+		present[i] = 1;
+	}
+	CHECK(json_addInteger(root, (unsigned char *)"o", (unsigned char *)"k1", 0) == JSON_EEXISTS, "a duplicate was allowed");
+	for (i = 0; i < 300; i++) {
+		sprintf(name, "o.k%d", i);
+		ret = json_getInteger(root, (unsigned char *)name, &n);
+		if (present[i]) CHECK(ret == JSON_ENONE && n == i, "%s: %d %d", name, ret, n);
+		else CHECK(ret == JSON_EMISSING, "%s should be gone: %d", name, ret);
+	}
+
+	/* an array, by position - take them out from the front, the back and the middle */
+	json_addArray(root, (unsigned char *)"", (unsigned char *)"a", &arr);
+	for (count = 0; count < 200; count++) {
+		json_addInteger(root, (unsigned char *)"a", NULL, count);
+		values[count] = count;
+	}
+	for (j = 0; j < 60; j++) {
+		/* a lookup, so that the next change has an index to keep up to date */
+		sprintf(name, "a[%d]", count / 2);
+		json_getInteger(root, (unsigned char *)name, &n);
+
+		switch (j % 4) {
+			case 0: i = 0; break;
+			case 1: i = count - 1; break;
+			case 2: i = count / 3; break;
+			default: i = -1; break;
+		}
+		if (i >= 0) {
+			sprintf(name, "a[%d]", i);
+			ret = json_deleteElement(root, (unsigned char *)name);
+			CHECK(ret == JSON_ENONE, "delete %s: %d", name, ret);
+			memmove(&values[i], &values[i + 1], sizeof(*values) * (count - i - 1));
+			count--;
+		} else {
+			json_addInteger(root, (unsigned char *)"a", NULL, 1000 + j);
+			values[count++] = 1000 + j;
+		}
+
+		ret = json_getArrayLen(root, (unsigned char *)"a", &len);
+		CHECK(ret == JSON_ENONE && len == (unsigned int)count, "array length: %d %u, not %d", ret, len, count);
+		for (i = 0; i < count; i++) {
+			sprintf(name, "a[%d]", i);
+			ret = json_getInteger(root, (unsigned char *)name, &n);
+			if (ret != JSON_ENONE || n != values[i]) break;
+		}
+		CHECK(i == count, "after change %d, a[%d] is wrong", j, i);
+	}
+
+	/* removing through a handle, from the front */
+	json_getInteger(root, (unsigned char *)"a[50]", &n);
+	for (i = 0; i < 10; i++) {
+		json_elementGetFirstChild(arr, &child);
+		json_elementRemove(child);
+	}
+	ret = json_getInteger(root, (unsigned char *)"a[0]", &n);
+	CHECK(ret == JSON_ENONE && n == values[10], "a[0] after removals: %d %d", ret, n);
+
+	/* names mean nothing to an array, even one with an index */
+	ret = json_getType(root, (unsigned char *)"a.k1", &type);
+	CHECK(ret == JSON_EMISSING, "a.k1: %d", ret);
+	json_addArray(root, (unsigned char *)"", (unsigned char *)"b", &arr);
+	for (i = 0; i < 40; i++) json_addInteger(root, (unsigned char *)"b", NULL, i);
+	ret = json_getInteger(root, (unsigned char *)"b[35]", &n);
+	CHECK(ret == JSON_ENONE && n == 35, "b[35]: %d %d", ret, n);
+	ret = json_getType(root, (unsigned char *)"b.foo", &type);
+	CHECK(ret == JSON_EMISSING, "b.foo: %d", ret);
+
+	json_destroy(json);
+}
+
+int main(void) {
+	unsigned char *data;
+	unsigned int len;
+
+	data = readFile("./testdata.json", &len);
+
+	checkChunked();
+	checkEscapes();
+	checkNumbers();
+	checkStream(data);
+	checkLazy(data, len);
+	checkProjection(data, len);
+	checkParallel();
+	checkIndexes();
+
+	free(data);
+
+	if (failures) {
+		fprintf(stderr, "%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("all checks passed\n");
+
+	return 0;
+}
@@ -0,0 +1,264 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "json_int.h"
+#include "scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86
+#endif
+
+/* the scanner works through the buffer in blocks of 64 bytes, building a bitmask
+   per character class and then pulling the boundaries out of the masks */
+#define SCAN_BLOCK 64
+
+enum scanClass {
+	SCAN_OTHER = 0,
+	SCAN_SPACE,
+	SCAN_SPECIAL, /* quotes and structural characters - always a boundary */
+};
+
+/* a constant table, so that there's nothing to set up when several threads start parsing at once */
+static const unsigned char scanClass[256] = {
+	[' '] = SCAN_SPACE, ['\t'] = SCAN_SPACE, ['\n'] = SCAN_SPACE,
+	['\v'] = SCAN_SPACE, ['\f'] = SCAN_SPACE, ['\r'] = SCAN_SPACE,
+	['"'] = SCAN_SPECIAL,
+	['{'] = SCAN_SPECIAL, ['}'] = SCAN_SPECIAL,
+	['['] = SCAN_SPECIAL, [']'] = SCAN_SPECIAL,
+	[':'] = SCAN_SPECIAL, [','] = SCAN_SPECIAL,
+};
+
+/* carries the class of the last byte of one block over to the next */
+struct scanCarry {
+	uint64_t space;
+	uint64_t other;
+};
+
+static inline unsigned int json_scanMasks(uint64_t special, uint64_t space, struct scanCarry *carry, unsigned int base, unsigned int *out) {
+	uint64_t other, bound;
+	unsigned int n;
+
+	other = ~(special | space);
+	bound  = special;
+	bound |= space & ~((space << 1) | carry->space);
+	bound |= other & ~((other << 1) | carry->other);
+	carry->space = space >> 63;
+	carry->other = other >> 63;
+
+	for (n = 0; bound; n++, bound &= bound - 1) {
+		out[n] = base + __builtin_ctzll(bound);
+	}
+
+	return n;
+}
+
+typedef unsigned int (*scanBlocks_t)(const unsigned char *data, unsigned int len, unsigned int base, struct scanCarry *carry, unsigned int *out);
+
+static unsigned int json_scanBlocks_scalar(const unsigned char *data, unsigned int len, unsigned int base, struct scanCarry *carry, unsigned int *out) {
+	unsigned int n, i, b;
+	uint64_t special, space;
+
+	for (n = 0, b = 0; b + SCAN_BLOCK <= len; b += SCAN_BLOCK) {
+		special = 0;
+		space = 0;
+		for (i = 0; i < SCAN_BLOCK; i++) {
+			switch (scanClass[data[b + i]]) {
+				case SCAN_SPACE:   space   |= 1ULL << i; break;
+				case SCAN_SPECIAL: special |= 1ULL << i; break;
+				default:;
+			}
+		}
+		n += json_scanMasks(special, space, carry, base + b, &(out[n]));
+	}
+
+	return n;
+}
+
+#ifdef SCAN_X86
+__attribute__((target("sse2")))
+static unsigned int json_scanBlocks_sse2(const unsigned char *data, unsigned int len, unsigned int base, struct scanCarry *carry, unsigned int *out) {
+	unsigned int n, b, i;
+	uint64_t special, space;
+	__m128i v, s, w, t;
+
+	for (n = 0, b = 0; b + SCAN_BLOCK <= len; b += SCAN_BLOCK) {
+		special = 0;
+		space = 0;
+		for (i = 0; i < SCAN_BLOCK; i += 16) {
+			v = _mm_loadu_si128((const __m128i *)&(data[b + i]));
+
+			s = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+			s = _mm_or_si128(s, _mm_cmpeq_epi8(v, _mm_set1_epi8(':')));
+			s = _mm_or_si128(s, _mm_cmpeq_epi8(v, _mm_set1_epi8(',')));
+			/* '[' / ']' and '{' / '}' differ only in bit 5 */
+			t = _mm_or_si128(v, _mm_set1_epi8(0x20));
+			s = _mm_or_si128(s, _mm_cmpeq_epi8(t, _mm_set1_epi8('{')));
+			s = _mm_or_si128(s, _mm_cmpeq_epi8(t, _mm_set1_epi8('}')));
+
+			/* '\t' - '\r' is a contiguous range */
+			t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+			w = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8('\r' - '\t')), t);
+			w = _mm_or_si128(w, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+
+			special |= (uint64_t)(uint16_t)_mm_movemask_epi8(s) << i;
+			space   |= (uint64_t)(uint16_t)_mm_movemask_epi8(w) << i;
+		}
+		n += json_scanMasks(special, space, carry, base + b, &(out[n]));
+	}
+
+	return n;
+}
+
+__attribute__((target("avx2")))
+static unsigned int json_scanBlocks_avx2(const unsigned char *data, unsigned int len, unsigned int base, struct scanCarry *carry, unsigned int *out) {
+	unsigned int n, b, i;
+	uint64_t special, space;
+	__m256i v, s, w, t;
+
+	for (n = 0, b = 0; b + SCAN_BLOCK <= len; b += SCAN_BLOCK) {
+		special = 0;
+		space = 0;
+		for (i = 0; i < SCAN_BLOCK; i += 32) {
+			v = _mm256_loadu_si256((const __m256i *)&(data[b + i]));
+
+			s = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'));
+			s = _mm256_or_si256(s, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')));
+			s = _mm256_or_si256(s, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')));
+			t = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+			s = _mm256_or_si256(s, _mm256_cmpeq_epi8(t, _mm256_set1_epi8('{')));
+			s = _mm256_or_si256(s, _mm256_cmpeq_epi8(t, _mm256_set1_epi8('}')));
+
+			t = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+			w = _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8('\r' - '\t')), t);
+			w = _mm256_or_si256(w, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+
+			special |= (uint64_t)(uint32_t)_mm256_movemask_epi8(s) << i;
+			space   |= (uint64_t)(uint32_t)_mm256_movemask_epi8(w) << i;
+		}
+		n += json_scanMasks(special, space, carry, base + b, &(out[n]));
+	}
+
+	return n;
+}
+#endif /* SCAN_X86 */
+
+static scanBlocks_t json_scanBlocks = NULL;
+static pthread_once_t json_scanOnce = PTHREAD_ONCE_INIT;
+
+/* pick the widest implementation that the CPU we are running on supports */
+static void json_scanSelect(void) {
+	scanBlocks_t f;
+
+	f = json_scanBlocks_scalar;
+#ifdef SCAN_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		f = json_scanBlocks_avx2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		f = json_scanBlocks_sse2;
+	}
+#endif
+	json_scanBlocks = f;
+}
+
+json_err json_scanInit(struct json_scan *scan) {
+	if (!scan) return JSON_EMISSINGPARAM;
+	/* json_dataParallel() can get here from several threads at once */
+	pthread_once(&json_scanOnce, json_scanSelect);
+	if (scan->pos) return JSON_ENONE;
+
+	if ((scan->pos = json_alloc(scan->allocator, sizeof(*scan->pos) * JSON_SCAN_WINDOW)) == NULL) return JSON_ENOMEM;
+	scan->len = 0;
+	scan->cur = 0;
+	scan->scanned = 0;
+
+	return JSON_ENONE;
+}
+
+void json_scanFree(struct json_scan *scan) {
+	if (!scan) return;
+	json_free(scan->allocator, scan->pos);
+	scan->pos = NULL;
+	scan->len = 0;
+	scan->cur = 0;
+	scan->scanned = 0;
+}
+
+void json_scanReset(struct json_scan *scan) {
+	if (!scan) return;
+	scan->len = 0;
+	scan->cur = 0;
+	scan->scanned = 0;
+}
+
+/* index the next window of the buffer, starting at 'start' */
+static void json_scanFill(struct json_scan *scan, struct json_buf *buf, unsigned int start) {
+	struct scanCarry carry;
+	unsigned int end, prev, i, n;
+
+	end = buf->pos;
+	if (end - start > JSON_SCAN_WINDOW) end = start + JSON_SCAN_WINDOW;
+
+	/* the class of the byte before 'start' decides if 'start' is itself a boundary */
+	prev = start ? scanClass[buf->data[start - 1]] : SCAN_SPACE;
+	carry.space = (prev == SCAN_SPACE);
+	carry.other = (prev == SCAN_OTHER);
+
+	n = json_scanBlocks(&(buf->data[start]), end - start, start, &carry, scan->pos);
+
+	/* pick up the tail that doesn't fill a whole block */
+	i = start + ((end - start) & ~(SCAN_BLOCK - 1));
+	if (i > start) prev = carry.space ? SCAN_SPACE : (carry.other ? SCAN_OTHER : SCAN_SPECIAL);
+	for (; i < end; i++) {
+		unsigned int c = scanClass[buf->data[i]];
+		if (c == SCAN_SPECIAL || c != prev) scan->pos[n++] = i;
+		prev = c;
+	}
+
+	scan->len = n;
+	scan->cur = 0;
+	scan->scanned = end;
+}
+
+unsigned int json_scanNext(struct json_scan *scan, struct json_buf *buf, unsigned int pos) {
+	for (;;) {
+		while (scan->cur < scan->len && scan->pos[scan->cur] < pos) scan->cur++;
+		if (scan->cur < scan->len) return scan->pos[scan->cur];
+
+		/* we've run out of boundaries... index some more of the buffer */
+		if (pos > scan->scanned) scan->scanned = pos;
+		if (scan->scanned >= buf->pos) return buf->pos;
+		json_scanFill(scan, buf, scan->scanned);
+	}
+}
+
+unsigned int json_scanSkipSpace(struct json_scan *scan, struct json_buf *buf, unsigned int pos) {
+	/* a run of whitespace only has a boundary at the start, so the next boundary ends it */
+	if (pos < buf->pos && scanClass[buf->data[pos]] == SCAN_SPACE) {
+		return json_scanNext(scan, buf, pos + 1);
+	}
+	return pos;
+}
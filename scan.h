@@ -0,0 +1,49 @@
+#ifndef __SCAN_H
+#define __SCAN_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* how many bytes of the parse buffer are indexed in one go */
+#define JSON_SCAN_WINDOW 4096
+
+/* the scanner records a 'boundary' for every quote and structural character,
+   and for the first byte of every run of whitespace / other characters.
+   between two boundaries, every byte is of the same class as the first */
+struct json_scan {
+	unsigned int *pos;
+	unsigned int len;
+	unsigned int cur;
+	unsigned int scanned;
+	const struct json_allocator *allocator; /* NULL = malloc() */
+};
+
+json_err json_scanInit(struct json_scan *scan);
+void json_scanFree(struct json_scan *scan);
+
+/* forget everything that has been indexed (e.g: because the buffer has moved) */
+void json_scanReset(struct json_scan *scan);
+
+/* returns the offset of the first boundary at or after 'pos', or buf->pos if there is none yet */
+unsigned int json_scanNext(struct json_scan *scan, struct json_buf *buf, unsigned int pos);
+
+/* returns the offset of the first non-whitespace character at or after 'pos', or buf->pos */
+unsigned int json_scanSkipSpace(struct json_scan *scan, struct json_buf *buf, unsigned int pos);
+
+#endif /* __SCAN_H */
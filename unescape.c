@@ -0,0 +1,233 @@
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "json_int.h"
+#include "unescape.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define UNESCAPE_X86
+#endif
+
+/* the plain parts of a string (ASCII, no '\\') are found in bulk, and just copied. escapes
+   and multi-byte UTF-8 sequences are dealt with one at a time as they turn up */
+
+typedef unsigned int (*unescapeScan_t)(const unsigned char *data, unsigned int len);
+
+static unsigned int json_unescapeScan_scalar(const unsigned char *data, unsigned int len) {
+	unsigned int i;
+	uint64_t v;
+
+	/* eight at a time - look for a set top bit, or a '\\' */
+	for (i = 0; i + 8 <= len; i += 8) {
+		memcpy(&v, &(data[i]), 8);
+		if (v & 0x8080808080808080ULL) break;
+		v ^= 0x5c5c5c5c5c5c5c5cULL;
+		if ((v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL) break;
+	}
+	for (; i < len; i++) {
+		if (data[i] == '\\' || data[i] & 0x80) break;
+	}
+
+	return i;
+}
+
+#ifdef UNESCAPE_X86
+__attribute__((target("sse2")))
+static unsigned int json_unescapeScan_sse2(const unsigned char *data, unsigned int len) {
+	unsigned int i, m;
+	__m128i v;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		v = _mm_loadu_si128((const __m128i *)&(data[i]));
+		/* the top bit of each byte is set for non-ASCII anyway */
+		m = _mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+		if (m) return i + __builtin_ctz(m);
+	}
+
+	return i + json_unescapeScan_scalar(&(data[i]), len - i);
+}
+
+__attribute__((target("avx2")))
+static unsigned int json_unescapeScan_avx2(const unsigned char *data, unsigned int len) {
+	unsigned int i, m;
+	__m256i v;
+
+	for (i = 0; i + 32 <= len; i += 32) {
+		v = _mm256_loadu_si256((const __m256i *)&(data[i]));
+		m = _mm256_movemask_epi8(_mm256_or_si256(v, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
+		if (m) return i + __builtin_ctz(m);
+	}
+
+	return i + json_unescapeScan_scalar(&(data[i]), len - i);
+}
+#endif /* UNESCAPE_X86 */
+
+static unescapeScan_t json_unescapeScanImpl = NULL;
+static pthread_once_t json_unescapeOnce = PTHREAD_ONCE_INIT;
+
+/* pick the widest implementation that the CPU we are running on supports */
+static void json_unescapeSelect(void) {
+	unescapeScan_t f;
+
+	f = json_unescapeScan_scalar;
+#ifdef UNESCAPE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		f = json_unescapeScan_avx2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		f = json_unescapeScan_sse2;
+	}
+#endif
+	json_unescapeScanImpl = f;
+}
+
+unsigned int json_unescapeScan(const unsigned char *data, unsigned int len) {
+	/* json_dataParallel() can get here from several threads at once */
+	pthread_once(&json_unescapeOnce, json_unescapeSelect);
+	return json_unescapeScanImpl(data, len);
+}
+
+static int json_unescapeHex(const unsigned char *data, unsigned int *value) {
+	unsigned int i, v;
+	unsigned char c;
+
+	for (i = 0, v = 0; i < 4; i++) {
+		c = data[i];
+		if      (c >= '0' && c <= '9') c -= '0';
+		else if (c >= 'a' && c <= 'f') c -= 'a' - 10;
+		else if (c >= 'A' && c <= 'F') c -= 'A' - 10;
+		else return 0;
+		v = (v << 4) | c;
+	}
+	*value = v;
+
+	return 1;
+}
+
+/* how long is the UTF-8 sequence at 'data'? 0 if it isn't valid */
+static unsigned int json_unescapeUTF8(const unsigned char *data, unsigned int len) {
+	unsigned int n, i;
+	unsigned char lo, hi;
+
+	lo = 0x80;
+	hi = 0xbf;
+	if (data[0] >= 0xc2 && data[0] <= 0xdf) {
+		n = 2;
+	} else if (data[0] >= 0xe0 && data[0] <= 0xef) {
+		n = 3;
+		/* no overlong forms, and no surrogates */
+		if (data[0] == 0xe0) lo = 0xa0;
+		if (data[0] == 0xed) hi = 0x9f;
+	} else if (data[0] >= 0xf0 && data[0] <= 0xf4) {
+		n = 4;
+		/* no overlong forms, and nothing above U+10FFFF */
+		if (data[0] == 0xf0) lo = 0x90;
+		if (data[0] == 0xf4) hi = 0x8f;
+	} else {
+		return 0;
+	}
+	if (n > len) return 0;
+
+	if (data[1] < lo || data[1] > hi) return 0;
+	for (i = 2; i < n; i++) {
+		if (data[i] < 0x80 || data[i] > 0xbf) return 0;
+	}
+
+	return n;
+}
+
+json_err json_unescape(const unsigned char *src, unsigned int len, unsigned char *dst, unsigned int *dstLen) {
+	unsigned int i, o, n, cp, lo;
+	unsigned char c;
+
+	if (!src || !dst || !dstLen) return JSON_EMISSINGPARAM;
+
+	for (i = 0, o = 0;;) {
+		n = json_unescapeScan(&(src[i]), len - i);
+		if (&(dst[o]) != &(src[i])) memmove(&(dst[o]), &(src[i]), n);
+		i += n;
+		o += n;
+		if (i >= len) break;
+
+		if (src[i] != '\\') {
+			if ((n = json_unescapeUTF8(&(src[i]), len - i)) == 0) return JSON_EINVAL;
+			memmove(&(dst[o]), &(src[i]), n);
+			i += n;
+			o += n;
+			continue;
+		}
+
+		if (i + 1 >= len) return JSON_EINVAL;
+		c = src[i + 1];
+		i += 2;
+		switch (c) {
+			case '"': case '\\': case '/':
+				dst[o++] = c;
+				continue;
+			case 'b': dst[o++] = '\b'; continue;
+			case 'f': dst[o++] = '\f'; continue;
+			case 'n': dst[o++] = '\n'; continue;
+			case 'r': dst[o++] = '\r'; continue;
+			case 't': dst[o++] = '\t'; continue;
+			case 'u':
+				break;
+			default:
+				return JSON_EINVAL;
+		}
+
+		/* \uXXXX - which might be the first half of a surrogate pair */
+		if (i + 4 > len || !json_unescapeHex(&(src[i]), &cp)) return JSON_EINVAL;
+		i += 4;
+		if (cp >= 0xdc00 && cp <= 0xdfff) return JSON_EINVAL;
+		if (cp >= 0xd800 && cp <= 0xdbff) {
+			if (i + 6 > len || src[i] != '\\' || src[i + 1] != 'u') return JSON_EINVAL;
+			if (!json_unescapeHex(&(src[i + 2]), &lo) || lo < 0xdc00 || lo > 0xdfff) return JSON_EINVAL;
+			i += 6;
+			cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+		}
+
+		/* the encoding is never longer than the escape, so this can't overtake 'src' */
+		if (cp < 0x80) {
+			dst[o++] = cp;
+		} else if (cp < 0x800) {
+			dst[o++] = 0xc0 | (cp >> 6);
+			dst[o++] = 0x80 | (cp & 0x3f);
+		} else if (cp < 0x10000) {
+			dst[o++] = 0xe0 | (cp >> 12);
+			dst[o++] = 0x80 | ((cp >> 6) & 0x3f);
+			dst[o++] = 0x80 | (cp & 0x3f);
+		} else {
+			dst[o++] = 0xf0 | (cp >> 18);
+			dst[o++] = 0x80 | ((cp >> 12) & 0x3f);
+			dst[o++] = 0x80 | ((cp >> 6) & 0x3f);
+			dst[o++] = 0x80 | (cp & 0x3f);
+		}
+	}
+
+	*dstLen = o;
+
+	return JSON_ENONE;
+}
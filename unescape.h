@@ -0,0 +1,31 @@
+#ifndef __UNESCAPE_H
+#define __UNESCAPE_H
+
+/*
+	libjson - a C library to parse and construct JSON data structures.
+
+	Copyright (C) 2012 onwards  Attie Grande (attie@attie.co.uk)
+
+	libjson is free software: you can redistribute it and/or modify it
+	under the terms of the GNU Lesser General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	libjson is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* returns the offset of the first '\\' or non-ASCII byte in 'data', or 'len' if there isn't one */
+unsigned int json_unescapeScan(const unsigned char *data, unsigned int len);
+
+/* decode the escapes in the 'len' bytes of a string at 'src' (without the quotes) into 'dst',
+   checking that it is valid UTF-8 as we go. 'dst' may be 'src', and needs at most 'len' bytes.
+   the decoded length is returned in 'dstLen' - the result is not terminated */
+json_err json_unescape(const unsigned char *src, unsigned int len, unsigned char *dst, unsigned int *dstLen);
+
+#endif /* __UNESCAPE_H */